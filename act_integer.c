@@ -82,6 +82,19 @@ _Bool act_mutate(ACT *act)
 	return mod;
 }
  
+size_t act_save(ACT *act, char *buf)
+{
+	if(buf != NULL)
+		memcpy(buf, &act->a, sizeof(int));
+	return sizeof(int);
+}
+
+size_t act_load(ACT *act, char *buf)
+{
+	memcpy(&act->a, buf, sizeof(int));
+	return sizeof(int);
+}
+
 void act_print(ACT *act)
 {
 	printf("action = %d\n", act->a);
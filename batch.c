@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The mini-batch training module.
+ *
+ * Trains on a batch of single-step problem instances whose rewards for every
+ * action are known. All inputs of the batch are matched against the
+ * population at once: the conditions' care and value bit masks are gathered,
+ * the inputs are packed into bits stored input-major within each word, and
+ * the B x N match matrix is computed classifier by classifier with the inner
+ * loop over the inputs. Each input then explores a random action and its action set is
+ * updated in turn; covering, action set subsumption, the GA and deletion are
+ * deferred to the end of the batch. A classifier covering an input earlier in
+ * the batch is reused, instead of covering again, by later inputs it matches.
+ *
+ * The deviation from online learning grows with the batch size and is
+ * reported by batch_stats: the covering classifiers created and reused, the
+ * action sets whose structural changes were deferred, and the members of
+ * those sets that had already been removed by the time their turn came.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "defer.h"
+#include "batch.h"
+
+void batch_match(char *states, int n);
+void batch_pack();
+
+int bt_words; // 64-bit words per packed condition or input
+int bt_num; // classifiers packed
+int bt_cap;
+CL **bt_cl; // packed classifiers in population order
+uint64_t *bt_care; // bits specified by each condition
+uint64_t *bt_val; // values of the specified bits
+int bt_in_cap; // inputs
+uint64_t *bt_in; // packed inputs, word w of input b at [w*n+b]
+uint64_t *bt_miss; // mismatching bits of each input
+CL ***bt_set; // match set of each input
+int *bt_size;
+int *bt_set_cap;
+CL **bt_new; // covering classifiers created in the current batch
+int bt_new_num;
+int bt_new_cap;
+CL **bt_mset; // match set of the input being explored, after covering
+CL **bt_aset; // its action set
+int bt_work_cap;
+DEFER bt_defer;
+long bt_covers;
+long bt_shared;
+long bt_sets;
+long bt_stale;
+
+void batch_init()
+{
+	bt_words = (state_length + 63) / 64;
+	bt_num = 0;
+	bt_cap = 0;
+	bt_cl = NULL;
+	bt_care = NULL;
+	bt_val = NULL;
+	bt_in_cap = 0;
+	bt_in = NULL;
+	bt_miss = NULL;
+	bt_set = NULL;
+	bt_size = NULL;
+	bt_set_cap = NULL;
+	bt_new = NULL;
+	bt_new_num = 0;
+	bt_new_cap = 0;
+	bt_mset = NULL;
+	bt_aset = NULL;
+	bt_work_cap = 0;
+	defer_init(&bt_defer);
+	bt_covers = 0;
+	bt_shared = 0;
+	bt_sets = 0;
+	bt_stale = 0;
+}
+
+void batch_free()
+{
+	free(bt_cl);
+	free(bt_care);
+	free(bt_val);
+	free(bt_in);
+	free(bt_miss);
+	for(int i = 0; i < bt_in_cap; i++)
+		free(bt_set[i]);
+	free(bt_set);
+	free(bt_size);
+	free(bt_set_cap);
+	free(bt_new);
+	free(bt_mset);
+	free(bt_aset);
+	defer_free(&bt_defer);
+}
+
+void batch_stats(long *covers, long *shared, long *sets, long *stale)
+{
+	*covers = bt_covers;
+	*shared = bt_shared;
+	*sets = bt_sets;
+	*stale = bt_stale;
+}
+
+void batch_pack()
+{
+	bt_num = 0;
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		if(bt_num == bt_cap) {
+			bt_cap = (bt_cap == 0) ? 256 : bt_cap * 2;
+			bt_cl = realloc(bt_cl, sizeof(CL*)*bt_cap);
+			bt_care = realloc(bt_care, sizeof(uint64_t)*bt_words*bt_cap);
+			bt_val = realloc(bt_val, sizeof(uint64_t)*bt_words*bt_cap);
+		}
+		CL *c = iter->cl;
+		memcpy(&bt_care[bt_num*bt_words], c->cond.care, sizeof(uint64_t)*bt_words);
+		memcpy(&bt_val[bt_num*bt_words], c->cond.val, sizeof(uint64_t)*bt_words);
+		bt_cl[bt_num++] = c;
+	}
+}
+
+void batch_match(char *states, int n)
+{
+	// match sets of the n inputs, each in population order
+	if(n > bt_in_cap) {
+		bt_in = realloc(bt_in, sizeof(uint64_t)*bt_words*n);
+		bt_miss = realloc(bt_miss, sizeof(uint64_t)*n);
+		bt_set = realloc(bt_set, sizeof(CL**)*n);
+		bt_size = realloc(bt_size, sizeof(int)*n);
+		bt_set_cap = realloc(bt_set_cap, sizeof(int)*n);
+		for(int i = bt_in_cap; i < n; i++) {
+			bt_set[i] = NULL;
+			bt_set_cap[i] = 0;
+		}
+		bt_in_cap = n;
+	}
+	memset(bt_in, 0, sizeof(uint64_t)*bt_words*n);
+	for(int b = 0; b < n; b++) {
+		char *state = &states[b*state_length];
+		for(int j = 0; j < state_length; j++) {
+			if(state[j] == '1')
+				bt_in[(j/64)*n+b] |= (uint64_t)1 << (j%64);
+		}
+		bt_size[b] = 0;
+	}
+	batch_pack();
+	for(int i = 0; i < bt_num; i++) {
+		uint64_t *care = &bt_care[i*bt_words];
+		uint64_t *val = &bt_val[i*bt_words];
+		for(int b = 0; b < n; b++)
+			bt_miss[b] = 0;
+		for(int w = 0; w < bt_words; w++) {
+			uint64_t c = care[w], v = val[w];
+			uint64_t *in = &bt_in[w*n];
+			for(int b = 0; b < n; b++)
+				bt_miss[b] |= (in[b] ^ v) & c;
+		}
+		for(int b = 0; b < n; b++) {
+			if(bt_miss[b] != 0)
+				continue;
+			if(bt_size[b] == bt_set_cap[b]) {
+				bt_set_cap[b] = (bt_set_cap[b] == 0) ? 64 : bt_set_cap[b] * 2;
+				bt_set[b] = realloc(bt_set[b], sizeof(CL*)*bt_set_cap[b]);
+			}
+			bt_set[b][bt_size[b]++] = bt_cl[i];
+		}
+	}
+}
+
+void batch_train(char *states, double *dstates, double *rewards, int n, int time)
+{
+	// explore trials on n inputs starting at the given time
+	batch_match(states, n);
+	bt_new_num = 0;
+	for(int b = 0; b < n; b++) {
+		char *state = &states[b*state_length];
+		double *dstate = &dstates[b*dstate_length];
+		_Bool covered[num_actions];
+		for(int a = 0; a < num_actions; a++)
+			covered[a] = false;
+		int m_num = 0;
+		for(int i = 0; i < bt_size[b]; i++) {
+			covered[bt_set[b][i]->act.a] = true;
+			m_num += bt_set[b][i]->num;
+		}
+		// cover the missing actions
+		int size = bt_size[b];
+		if(size + num_actions > bt_work_cap) {
+			bt_work_cap = 2 * (size + num_actions);
+			bt_mset = realloc(bt_mset, sizeof(CL*)*bt_work_cap);
+			bt_aset = realloc(bt_aset, sizeof(CL*)*bt_work_cap);
+		}
+		CL **mset = bt_mset;
+		if(size > 0)
+			memcpy(mset, bt_set[b], sizeof(CL*)*size);
+		for(int a = 0; a < num_actions; a++) {
+			if(covered[a])
+				continue;
+			CL *c = NULL;
+			for(int i = 0; i < bt_new_num && c == NULL; i++) {
+				if(bt_new[i]->act.a == a && cond_match(&bt_new[i]->cond, state, dstate))
+					c = bt_new[i];
+			}
+			if(c != NULL)
+				bt_shared++;
+			else {
+				c = malloc(sizeof(CL));
+				cl_init(c, m_num+1, time+b);
+				cl_cover(c, state, dstate, a);
+				defer_cover(&bt_defer, c);
+				if(bt_new_num == bt_new_cap) {
+					bt_new_cap = (bt_new_cap == 0) ? 16 : bt_new_cap * 2;
+					bt_new = realloc(bt_new, sizeof(CL*)*bt_new_cap);
+				}
+				bt_new[bt_new_num++] = c;
+				bt_covers++;
+			}
+			mset[size++] = c;
+			m_num += c->num;
+		}
+		// explore a random action
+		int action = irand(0, num_actions);
+		CL **aset = bt_aset;
+		int asize = 0, anum = 0;
+		for(int i = 0; i < size; i++) {
+			if(mset[i]->act.a == action) {
+				aset[asize++] = mset[i];
+				anum += mset[i]->num;
+			}
+		}
+		defer_update(aset, asize, rewards[b*num_actions+action], dstate);
+		double time_sum = 0.0;
+		for(int i = 0; i < asize; i++)
+			time_sum += aset[i]->time * aset[i]->num;
+		if(ACTION_SUBSUMPTION || time+b - time_sum / anum >= THETA_GA) {
+			defer_set(&bt_defer, aset, asize, time+b, state);
+			bt_sets++;
+		}
+	}
+	// structural changes
+	NODE *kset = NULL;
+	bt_stale += defer_apply(&bt_defer, &kset);
+	defer_fold(&kset);
+	set_kill(&kset);
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+void batch_free();
+void batch_init();
+void batch_stats(long *covers, long *shared, long *sets, long *stale);
+void batch_train(char *states, double *dstates, double *rewards, int n, int time);
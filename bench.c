@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description:
+ **************
+ * The population benchmark.
+ *
+ * Times population queries and updates against simpler ways of making them
+ * on a random population, checking that the results are the same:
+ *
+ *   xcsbench trie stateLength pDontCare popSize queries
+ *   xcsbench sindex inputs s0 popSize queries
+ *   xcsbench subsume stateLength popSize queries
+ *
+ * trie makes match, more general, more specific, duplicate and covering
+ * queries of the ternary trie (MATCH_INDEX=3). sindex makes match, more
+ * general and duplicate queries of the spatial index of interval conditions,
+ * matching against the vectorised scan. The conditions queried are those of
+ * random classifiers of the population.
+ *
+ * subsume runs action set subsumption on the action sets of random states,
+ * every classifier of which is made a subsumer, once compacting the set and
+ * population after each victim and once with set_subsumption.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "pstat.h"
+#include "trie.h"
+#include "sindex.h"
+#include "imatch.h"
+#include "xcs.h"
+
+#define BENCH_MATCH 0
+#define BENCH_GENERAL 1
+#define BENCH_SPECIFIC 2
+#define BENCH_DUPLICATE 3
+#define BENCH_COVERS 4
+
+_Bool bench_same(NODE *a, NODE *b);
+double bench_time();
+int bench_queries(char **argv);
+int bench_subsume(char **argv);
+void bench_index(NODE **set, int q, CL *c, char *state, double *dstate);
+void bench_input(char *state, double *dstate);
+void bench_linear(NODE **set, int q, CL *c, char *state, double *dstate);
+void bench_subsume_each(NODE **set, int *size, int *num, NODE **kset);
+
+char *bn_names[] = {"match", "general", "specific", "duplicate", "covers"};
+
+int main(int argc, char **argv)
+{
+	random_init();
+	if(argc == 6 && (strcmp(argv[1], "trie") == 0
+				|| strcmp(argv[1], "sindex") == 0))
+		return bench_queries(argv);
+	if(argc == 5 && strcmp(argv[1], "subsume") == 0)
+		return bench_subsume(argv);
+	printf("Usage: xcsbench trie stateLength pDontCare popSize queries\n");
+	printf("       xcsbench sindex inputs s0 popSize queries\n");
+	printf("       xcsbench subsume stateLength popSize queries\n");
+	exit(EXIT_FAILURE);
+}
+
+int bench_queries(char **argv)
+{
+	XCS_PARAMS p;
+	xcs_default_params(&p);
+	_Bool trie = (strcmp(argv[1], "trie") == 0);
+	p.cond_type = trie ? 0 : 1;
+	p.match_index = trie ? 3 : 1;
+	p.state_length = atoi(argv[2]);
+	p.num_actions = 2;
+	if(trie)
+		p.p_dontcare = atof(argv[3]);
+	else
+		p.cond_s0 = atof(argv[3]);
+	p.pop_size = atoi(argv[4]);
+	p.pop_init = true;
+	p.seed = 1;
+	int queries = atoi(argv[5]);
+	double start = bench_time();
+	XCS *x = xcs_create(&p);
+	if(x == NULL) {
+		printf("Error creating the population\n");
+		exit(EXIT_FAILURE);
+	}
+	printf("%d classifiers added in %.2fs\n", pop_num, bench_time() - start);
+	printf("query      index (us)  scan (us)  found\n");
+	char state[state_length];
+	double dstate[dstate_length];
+	for(int q = BENCH_MATCH; q <= BENCH_COVERS; q++) {
+		if(!trie && (q == BENCH_SPECIFIC || q == BENCH_COVERS))
+			continue;
+		double ti = 0.0, tl = 0.0;
+		long found = 0;
+		for(int i = 0; i < queries; i++) {
+			// the input and a classifier of the population to query
+			bench_input(state, dstate);
+			int n = irand(0, pop_num);
+			NODE *iter = pset;
+			for(int j = 0; j < n; j++)
+				iter = iter->next;
+			CL *c = iter->cl;
+			NODE *si = NULL, *sl = NULL;
+			start = bench_time();
+			bench_index(&si, q, c, state, dstate);
+			ti += bench_time() - start;
+			start = bench_time();
+			bench_linear(&sl, q, c, state, dstate);
+			tl += bench_time() - start;
+			_Bool same = (q == BENCH_COVERS) ? ((si == NULL) == (sl == NULL))
+				: bench_same(si, sl);
+			if(!same) {
+				printf("%s query %d differs from the scan\n", bn_names[q], i);
+				exit(EXIT_FAILURE);
+			}
+			for(iter = sl; iter != NULL; iter = iter->next)
+				found++;
+			set_free(&si);
+			set_free(&sl);
+		}
+		printf("%-10s %10.1f %10.1f %6.1f\n", bn_names[q],
+				ti * 1e6 / queries, tl * 1e6 / queries,
+				(double)found / queries);
+	}
+	xcs_destroy(x);
+	return EXIT_SUCCESS;
+}
+
+void bench_index(NODE **set, int q, CL *c, char *state, double *dstate)
+{
+	// the answer of query q from the index
+	CL *d = NULL;
+	if(COND_TYPE == 1) {
+		if(q == BENCH_MATCH)
+			sindex_match(set, dstate);
+		else if(q == BENCH_GENERAL)
+			sindex_general(set, &c->cond);
+		else
+			d = sindex_duplicate(c);
+	}
+	else {
+		if(q == BENCH_MATCH)
+			trie_match(set, state);
+		else if(q == BENCH_GENERAL)
+			trie_general(set, &c->cond);
+		else if(q == BENCH_SPECIFIC)
+			trie_specific(set, &c->cond);
+		else if(q == BENCH_DUPLICATE)
+			d = trie_duplicate(c);
+		// any classifier stands for a covered action
+		else if(trie_covers(state, c->act.a))
+			d = c;
+	}
+	if(d != NULL)
+		set_add(set, d);
+	set_order(set);
+}
+
+void bench_linear(NODE **set, int q, CL *c, char *state, double *dstate)
+{
+	// the answer of query q from a walk of the population, or the
+	// vectorised scan when matching intervals
+	if(COND_TYPE == 1 && q == BENCH_MATCH) {
+		imatch_get(set, dstate);
+		return;
+	}
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		CL *p = iter->cl;
+		_Bool in;
+		if(q == BENCH_MATCH)
+			in = cond_match(&p->cond, state, dstate);
+		else if(q == BENCH_GENERAL)
+			in = cond_general(&p->cond, &c->cond);
+		else if(q == BENCH_SPECIFIC)
+			in = cond_general(&c->cond, &p->cond);
+		else if(q == BENCH_DUPLICATE)
+			in = cl_duplicate(c, p);
+		else
+			in = (p->act.a == c->act.a && cond_match(&p->cond, state, dstate));
+		if(in) {
+			set_add(set, p);
+			// one answer is enough
+			if(q >= BENCH_DUPLICATE)
+				break;
+		}
+	}
+	set_order(set);
+}
+
+_Bool bench_same(NODE *a, NODE *b)
+{
+	// whether two sets in population order hold the same classifiers
+	while(a != NULL && b != NULL) {
+		if(a->cl != b->cl)
+			return false;
+		a = a->next;
+		b = b->next;
+	}
+	return a == NULL && b == NULL;
+}
+
+int bench_subsume(char **argv)
+{
+	XCS_PARAMS p;
+	xcs_default_params(&p);
+	p.state_length = atoi(argv[2]);
+	p.num_actions = 2;
+	p.pop_size = atoi(argv[3]);
+	p.pop_init = true;
+	p.seed = 1;
+	int queries = atoi(argv[4]);
+	char state[p.state_length];
+	double dstate[p.state_length];
+	long victims[2];
+	int left[2];
+	printf("compaction          time (s)  victims  classifiers left\n");
+	for(int run = 0; run < 2; run++) {
+		XCS *x = xcs_create(&p);
+		if(x == NULL) {
+			printf("Error creating the population\n");
+			exit(EXIT_FAILURE);
+		}
+		double t = 0.0;
+		victims[run] = 0;
+		for(int i = 0; i < queries; i++) {
+			bench_input(state, dstate);
+			NODE *mset = NULL, *aset = NULL, *kset = NULL;
+			pop_match(&mset, state, dstate);
+			int num = 0;
+			int size = set_action(&mset, &aset, irand(0, num_actions), &num);
+			for(NODE *iter = aset; iter != NULL; iter = iter->next) {
+				iter->cl->exp = THETA_SUB + 1;
+				iter->cl->err = 0.0;
+			}
+			double start = bench_time();
+			if(run == 0)
+				bench_subsume_each(&aset, &size, &num, &kset);
+			else
+				set_subsumption(&aset, &size, &num, &kset);
+			t += bench_time() - start;
+			for(NODE *iter = kset; iter != NULL; iter = iter->next)
+				victims[run]++;
+			set_free(&mset);
+			set_free(&aset);
+			set_kill(&kset);
+		}
+		left[run] = pop_num;
+		printf("%-18s %9.3f %8ld %17d\n", (run == 0) ? "after each victim"
+				: "once per set", t, victims[run], left[run]);
+		xcs_destroy(x);
+	}
+	if(victims[0] != victims[1] || left[0] != left[1]) {
+		printf("the subsumptions differ\n");
+		exit(EXIT_FAILURE);
+	}
+	return EXIT_SUCCESS;
+}
+
+void bench_subsume_each(NODE **set, int *size, int *num, NODE **kset)
+{
+	// set_subsumption compacting the set and the population after each
+	// subsumed classifier
+	CL *s = NULL;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next) {
+		CL *c = iter->cl;
+		if(cl_subsumer(c)) {
+			if(s == NULL || cond_general(&c->cond, &s->cond))
+				s = c;
+		}
+	}
+	if(s == NULL)
+		return;
+	NODE *iter = *set;
+	while(iter != NULL) {
+		CL *c = iter->cl;
+		iter = iter->next;
+		if(cond_general(&s->cond, &c->cond)) {
+			s->num += c->num;
+			pstat_num(s, c->num);
+			pstat_num(c, -c->num);
+			c->num = 0;
+			pop_index_del(c);
+			set_add(kset, c);
+			set_validate(set, size, num);
+			set_validate(&pset, &pop_num, &pop_num_sum);
+		}
+	}
+}
+
+void bench_input(char *state, double *dstate)
+{
+	// a random input: bits, or reals in [-1,1] for interval conditions
+	for(int i = 0; i < state_length; i++)
+		state[i] = (drand() < 0.5) ? '0' : '1';
+	for(int i = 0; i < dstate_length; i++) {
+		if(COND_TYPE == 1)
+			dstate[i] = drand() * 2.0 - 1.0;
+		else
+			dstate[i] = (state[i] == '1') ? 1.0 : -1.0;
+	}
+}
+
+double bench_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
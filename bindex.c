@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The inverted bitset matching index module.
+ *
+ * For each bit of the input and each of its two values a bitset over the
+ * population slots records the classifiers that do not match that value,
+ * i.e., those specifying the opposite symbol. The match set for a state is
+ * the complement of the union of the bitsets selected by the state's bits,
+ * which is computed a block of words at a time with simple loops the compiler
+ * vectorises. In automatic mode the index is used while its estimated cost,
+ * the words ORed, is below that of a linear scan of the population; the
+ * estimate uses counts rather than timings so that runs are reproducible.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "bindex.h"
+
+#define BINDEX_BLOCK 64 // words processed at a time
+#define BINDEX_SCAN 24 // words ORed in the time a scan matches a classifier
+
+void bindex_grow(int id);
+
+int bi_words; // number of 64-bit words per bitset
+CL **bi_cl; // classifier in each slot
+uint64_t *bi_live; // slots in use
+uint64_t *bi_bits; // 2 bitsets per bit: slots not matching '0' then '1'
+
+void bindex_init()
+{
+	bi_words = 0;
+	bi_cl = NULL;
+	bi_live = NULL;
+	bi_bits = NULL;
+}
+
+void bindex_free()
+{
+	free(bi_cl);
+	free(bi_live);
+	free(bi_bits);
+}
+
+void bindex_grow(int id)
+{
+	// make room for slot id, keeping each bitset contiguous
+	if(id < bi_words*64)
+		return;
+	int words = bi_words;
+	while(words*64 <= id)
+		words = (words == 0) ? BINDEX_BLOCK : words * 2;
+	uint64_t *bits = calloc((size_t)2*state_length*words, sizeof(uint64_t));
+	for(int i = 0; i < 2*state_length && bi_words > 0; i++)
+		memcpy(&bits[i*words], &bi_bits[i*bi_words], sizeof(uint64_t)*bi_words);
+	free(bi_bits);
+	bi_bits = bits;
+	bi_live = realloc(bi_live, sizeof(uint64_t)*words);
+	memset(&bi_live[bi_words], 0, sizeof(uint64_t)*(words-bi_words));
+	bi_cl = realloc(bi_cl, sizeof(CL*)*words*64);
+	bi_words = words;
+}
+
+void bindex_add(CL *c)
+{
+	// a new macro-classifier has been added to the population
+	int id = c->id;
+	bindex_grow(id);
+	uint64_t bit = 1ULL << (id % 64);
+	int w = id / 64;
+	bi_cl[id] = c;
+	bi_live[w] |= bit;
+	for(int i = 0; i < state_length; i++) {
+		if(c->cond.string[i] == '0')
+			bi_bits[(2*i+1)*bi_words+w] |= bit;
+		else if(c->cond.string[i] == '1')
+			bi_bits[(2*i)*bi_words+w] |= bit;
+	}
+}
+
+void bindex_del(CL *c)
+{
+	// a macro-classifier has been removed from the population
+	int id = c->id;
+	uint64_t bit = ~(1ULL << (id % 64));
+	int w = id / 64;
+	bi_live[w] &= bit;
+	for(int i = 0; i < state_length; i++) {
+		bi_bits[(2*i)*bi_words+w] &= bit;
+		bi_bits[(2*i+1)*bi_words+w] &= bit;
+	}
+}
+
+void bindex_get(NODE **mset, char *state)
+{
+	// builds the match set from the index
+	uint64_t acc[BINDEX_BLOCK];
+	for(int start = 0; start < bi_words; start += BINDEX_BLOCK) {
+		for(int w = 0; w < BINDEX_BLOCK; w++)
+			acc[w] = 0;
+		for(int i = 0; i < state_length; i++) {
+			uint64_t *b = &bi_bits[(2*i+(state[i]=='1'))*bi_words+start];
+			for(int w = 0; w < BINDEX_BLOCK; w++)
+				acc[w] |= b[w];
+		}
+		for(int w = 0; w < BINDEX_BLOCK; w++) {
+			uint64_t m = bi_live[start+w] & ~acc[w];
+			while(m != 0) {
+				set_add(mset, bi_cl[(start+w)*64 + __builtin_ctzll(m)]);
+				m &= m - 1;
+			}
+		}
+	}
+	set_order(mset);
+}
+
+_Bool bindex_faster()
+{
+	// the index ORs a bitset word per input bit for every 64 slots, while a
+	// scan follows the population list to each classifier
+	return (double)state_length * bi_words < (double)BINDEX_SCAN * pop_num;
+}
@@ -47,6 +47,8 @@ void cl_init(CL *c, int size, int time)
 	c->exp = 0;
 	c->size = size;
 	c->time = time;
+	c->id = -1;
+	c->stamp = 0;
 #ifdef SELF_ADAPT_MUTATION
 	sam_init(c);
 #endif
@@ -63,9 +65,9 @@ void cl_copy(CL *to, CL *from)
 #endif
 }
 
-void cl_cover(CL *c, char *state, int i)
+void cl_cover(CL *c, char *state, double *dstate, int i)
 {
-	cond_cover(&c->cond, state);
+	cond_cover(&c->cond, state, dstate);
 	act_cover(&c->act, state, i);
 }
 
@@ -154,6 +156,48 @@ void cl_free(CL *c)
 	free(c);
 }
 
+size_t cl_save(CL *c, char *buf)
+{
+	// writes the classifier to buf (unless NULL) and returns the bytes used
+	double d[3] = {c->err, c->fit, c->size};
+	int i[3] = {c->num, c->exp, c->time};
+	size_t s = sizeof(d) + sizeof(i);
+	if(buf != NULL) {
+		memcpy(buf, d, sizeof(d));
+		memcpy(buf+sizeof(d), i, sizeof(i));
+	}
+	s += cond_save(&c->cond, buf ? buf+s : NULL);
+	s += act_save(&c->act, buf ? buf+s : NULL);
+	s += pred_save(&c->pred, buf ? buf+s : NULL);
+#ifdef SELF_ADAPT_MUTATION
+	s += sam_save(c, buf ? buf+s : NULL);
+#endif
+	return s;
+}
+
+size_t cl_load(CL *c, char *buf)
+{
+	// reads a classifier written by cl_save into an initialised classifier
+	double d[3];
+	int i[3];
+	memcpy(d, buf, sizeof(d));
+	memcpy(i, buf+sizeof(d), sizeof(i));
+	c->err = d[0];
+	c->fit = d[1];
+	c->size = d[2];
+	c->num = i[0];
+	c->exp = i[1];
+	c->time = i[2];
+	size_t s = sizeof(d) + sizeof(i);
+	s += cond_load(&c->cond, buf+s);
+	s += act_load(&c->act, buf+s);
+	s += pred_load(&c->pred, buf+s);
+#ifdef SELF_ADAPT_MUTATION
+	s += sam_load(c, buf+s);
+#endif
+	return s;
+}
+
 void cl_print(CL *c)
 {
 	cond_print(&c->cond);
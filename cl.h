@@ -26,14 +26,16 @@ typedef struct CL
 	COND cond;
 	ACT act;
 	PRED pred;
-	double err;
-	double fit;
+	REAL err;
+	REAL fit;
 	int num;
 	int exp;
-	double size;
+	REAL size;
 	int time;
+	int id; // population slot used by the matching modules
+	long stamp; // order of entry into the population, followed by matching
 #ifdef SELF_ADAPT_MUTATION
-	double *mu;
+	REAL *mu;
 #endif
 } CL;
 
@@ -43,8 +45,10 @@ _Bool cl_subsumer(CL *c);
 _Bool cl_subsumes(CL *c1, CL *c2);
 double cl_acc(CL *c);
 double cl_del_vote(CL *c, double avg_fit);
+size_t cl_load(CL *c, char *buf);
+size_t cl_save(CL *c, char *buf);
 void cl_copy(CL *to, CL *from);
-void cl_cover(CL *c, char *state, int i);
+void cl_cover(CL *c, char *state, double *dstate, int i);
 void cl_free(CL *c);
 void cl_init(CL *c, int size, int time);
 void cl_print(CL *c);
@@ -56,11 +60,13 @@ _Bool cond_crossover(COND *cond1, COND *cond2);
 _Bool cond_duplicate(COND *cond1, COND *cond2);
 _Bool cond_general(COND *cond1, COND *cond2);
 _Bool cond_mutate(COND *cond, char *state);
-_Bool cond_match(COND *cond, char *state);
+_Bool cond_match(COND *cond, char *state, double *dstate);
 void cond_copy(COND *to, COND *from);
 void cond_free(COND *cond);
 void cond_init(COND *cond);
-void cond_cover(COND *cond, char *mcon);
+size_t cond_load(COND *cond, char *buf);
+size_t cond_save(COND *cond, char *buf);
+void cond_cover(COND *cond, char *mcon, double *dstate);
 void cond_print(COND *cond);
 void cond_rand(COND *cond);
 
@@ -70,13 +76,19 @@ _Bool act_mutate(ACT *act);
 void act_copy(ACT *to, ACT *from);
 void act_free(ACT *act);
 void act_init(ACT *act);
+size_t act_load(ACT *act, char *buf);
+size_t act_save(ACT *act, char *buf);
 void act_cover(ACT *act, char *state, int i);
 void act_print(ACT *act);
 void act_rand(ACT *act);
 
 // classifier prediction
 double pred_compute(PRED *pred, double *state);
+double pred_eval(REAL *w, double *state);
+int pred_coeffs(PRED *pred, REAL *w);
 double pred_update_err(PRED *pred, double p, double *state);
+size_t pred_load(PRED *pred, char *buf);
+size_t pred_save(PRED *pred, char *buf);
 void pred_update(PRED *pred, double p, double *state);
 void pred_copy(PRED *to, PRED *from);
 void pred_free(PRED *pred);
@@ -84,6 +96,8 @@ void pred_init(PRED *pred);
 void pred_print(PRED *pred);
 
 // self-adaptive mutation
+size_t sam_load(CL *c, char *buf);
+size_t sam_save(CL *c, char *buf);
 void sam_adapt(CL *c);       
 void sam_copy(CL *to, CL *from);
 void sam_free(CL *c);
@@ -31,16 +31,81 @@
 #include "random.h"
 #include "cl.h"
 #include "cl_set.h"
+#include "mcache.h"
+#include "dmatch.h"
+#include "bindex.h"
+#include "trie.h"
+#include "imatch.h"
+#include "sindex.h"
+#include "batch.h"
+#include "ga_async.h"
+#include "tpool.h"
+#include "pstat.h"
 
-_Bool set_action_covered(NODE **set, int action);
-void set_subsumption(NODE **set, int *size, int *num, NODE **kset);
+#define PAR_CHUNK 1024 // population slots matched per parallel chunk
+
+int set_mark_actions(NODE **set);
+void pop_index_add(CL *c);
+void pop_scan_chunk(int chunk, void *state);
+void pop_scan_par(NODE **mset, char *state);
+NODE *node_alloc();
+void node_release(NODE *n);
 void set_update_fit(NODE **set, int size, int num_sum);
+int set_order_cmp(const void *a, const void *b);
+
+int *pop_ids; // stack of free population slot ids
+int pop_ids_num;
+int pop_ids_cap;
+int pop_ids_next; // next never used slot id
+NODE *node_pool; // released set nodes
+CL **pop_slots; // classifier in each slot id, or NULL
+int pop_slots_cap;
+CL **par_match; // matching classifiers found by each parallel chunk
+int *par_match_num;
+int par_chunks_cap;
+int *pop_act_mark; // stamp of the last set found advocating each action
+int pop_act_stamp;
+long pop_stamp; // stamp of the next classifier to enter the population
+CL **ord_buf; // match set being put in scan order
+int ord_cap;
 
 void pop_init()
 {
 	pset = NULL; // population linked list
 	pop_num = 0; // num macro-classifiers
 	pop_num_sum = 0; // numerosity sum
+	pop_ids = NULL;
+	pop_ids_num = 0;
+	pop_ids_cap = 0;
+	pop_ids_next = 0;
+	pop_slots = NULL;
+	pop_slots_cap = 0;
+	node_pool = NULL;
+	par_match = NULL;
+	par_match_num = NULL;
+	par_chunks_cap = 0;
+	pop_act_mark = calloc(num_actions, sizeof(int));
+	pop_act_stamp = 0;
+	pop_stamp = 0;
+	ord_buf = NULL;
+	ord_cap = 0;
+	if(MATCH_CACHE_SIZE > 0)
+		mcache_init();
+	if(MATCH_DELTA)
+		dmatch_init();
+	if(COND_TYPE == 0 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		bindex_init();
+	if(MATCH_INDEX == 3)
+		trie_init();
+	if(COND_TYPE == 1)
+		imatch_init();
+	if(COND_TYPE == 1 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		sindex_init();
+	if(BATCH_SIZE > 1)
+		batch_init();
+	if(GA_QUEUE > 0)
+		ga_async_init();
+	pstat_init();
 
 	if(POP_INIT) {
 		while(pop_num < POP_SIZE) {
@@ -53,40 +118,39 @@ void pop_init()
 	}
 }
 
-void set_match(NODE **mset, char *state, int time, NODE **kset)
+void set_match(NODE **mset, char *state, double *dstate, int time, NODE **kset)
 {
 	// builds the match set
 	int m_num = 0;
 	int m_size = 0;
-	_Bool act_covered[num_actions];
-	for(int i = 0; i < num_actions; i++)
-		act_covered[i] = false;
+	int mna = (THETA_MNA > 0 && THETA_MNA < num_actions) ? THETA_MNA : num_actions;
 
 	// find matching classifiers in the population
-	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
-		if(cond_match(&iter->cl->cond, state)) {
-			set_add(mset, iter->cl);
-			act_covered[iter->cl->act.a] = true;
-			m_num += iter->cl->num;
-			m_size++;
-		}
+	pop_match(mset, state, dstate);
+	int covered = set_mark_actions(mset);
+	for(NODE *iter = *mset; iter != NULL; iter = iter->next) {
+		m_num += iter->cl->num;
+		m_size++;
 	}   
 
-	// perform covering if all actions are not represented
+	// perform covering if fewer than mna actions are represented: all
+	// missing actions in order, or random ones when mna is lower
 	_Bool again;
 	do {
 		again = false;
-		for(int i = 0; i < num_actions; i++) {
-			if(!act_covered[i]) {
+		for(int i = 0; covered < mna; i++) {
+			int a = (mna == num_actions) ? i : irand(0, num_actions);
+			if(pop_act_mark[a] != pop_act_stamp) {
 				// new classifier with matching condition & action
 				CL *new = malloc(sizeof(CL));
 				cl_init(new, m_num+1, time);
-				cl_cover(new, state, i);
+				cl_cover(new, state, dstate, a);
 				pop_add(new);
 				set_add(mset, new);
 				m_size++;
 				m_num++;
-				act_covered[i] = true;
+				pop_act_mark[a] = pop_act_stamp;
+				covered++;
 			}
 		}
 
@@ -98,27 +162,103 @@ void set_match(NODE **mset, char *state, int time, NODE **kset)
 			int prev_msize = m_size;
 			set_validate(mset, &m_size, &m_num);
 			// if the deleted classifier was in the match set,
-			// check if an action is now not covered
+			// check if too few actions are now covered
 			if(prev_msize > m_size) {
-				for(int i = 0; i < num_actions; i++) {
-					if(!set_action_covered(mset, i)) {
-						act_covered[i] = false;
-						again = true;
-					}
-				}
+				covered = set_mark_actions(mset);
+				again = (covered < mna);
 			}
 		}
 	} while(again);
 }
 
-_Bool set_action_covered(NODE **set, int action)
+int set_mark_actions(NODE **set)
 {
-	// check whether an action is represented in the set
+	// stamps the actions advocated in the set and returns their number
+	pop_act_stamp++;
+	int n = 0;
 	for(NODE *iter = *set; iter != NULL; iter = iter->next) {
-		if(iter->cl->act.a == action)
-			return true;
+		int a = iter->cl->act.a;
+		if(pop_act_mark[a] != pop_act_stamp) {
+			pop_act_mark[a] = pop_act_stamp;
+			n++;
+		}
+	}
+	return n;
+}
+
+void pop_match(NODE **mset, char *state, double *dstate)
+{
+	// selects the matching method; every method gives the match set in the
+	// order of a scan of the population, so the choice does not change the run
+	if(COND_TYPE == 1) {
+		if(MATCH_INDEX == 1 || (MATCH_INDEX == 2 && sindex_faster(dstate)))
+			sindex_match(mset, dstate);
+		else
+			imatch_get(mset, dstate);
+		return;
+	}
+	if(MATCH_DELTA) {
+		dmatch_get(mset, state);
+		return;
+	}
+	if(MATCH_CACHE_SIZE > 0 && mcache_get(mset, state))
+		return;
+	if(MATCH_INDEX == 1 || (MATCH_INDEX == 2 && bindex_faster()))
+		bindex_get(mset, state);
+	else if(MATCH_INDEX == 3)
+		trie_match(mset, state);
+	else if(pop_num >= PAR_MATCH_MIN)
+		pop_scan_par(mset, state);
+	else
+		pop_scan(mset, state);
+	if(MATCH_CACHE_SIZE > 0)
+		mcache_put(mset, state);
+}
+
+void pop_scan(NODE **mset, char *state)
+{
+	// linear scan of the population; the list holds the newest classifier
+	// first, so the match set holds the oldest first
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		if(cond_match(&iter->cl->cond, state, NULL))
+			set_add(mset, iter->cl);
+	}
+}
+
+void pop_scan_par(NODE **mset, char *state)
+{
+	// linear scan of the population slots in fixed size chunks shared
+	// between threads; the chunk results are joined in slot order so the
+	// match set does not depend on the number of threads
+	int chunks = (pop_ids_next + PAR_CHUNK - 1) / PAR_CHUNK;
+	if(chunks > par_chunks_cap) {
+		par_chunks_cap = chunks;
+		par_match = realloc(par_match, sizeof(CL*)*chunks*PAR_CHUNK);
+		par_match_num = realloc(par_match_num, sizeof(int)*chunks);
+	}
+	tpool_run(pop_scan_chunk, state, chunks);
+	for(int i = 0; i < chunks; i++) {
+		for(int j = 0; j < par_match_num[i]; j++)
+			set_add(mset, par_match[i*PAR_CHUNK+j]);
+	}
+	set_order(mset);
+}
+
+void pop_scan_chunk(int chunk, void *state)
+{
+	int start = chunk * PAR_CHUNK;
+	int end = start + PAR_CHUNK;
+	if(end > pop_ids_next)
+		end = pop_ids_next;
+	int num = 0;
+	for(int i = start; i < end; i++) {
+		CL *c = pop_slots[i];
+		if(c != NULL && cond_match(&c->cond, state, NULL)) {
+			par_match[start+num] = c;
+			num++;
+		}
 	}
-	return false;
+	par_match_num[chunk] = num;
 }
 
 int set_action(NODE **mset, NODE **aset, int action, int *num)
@@ -135,49 +275,166 @@ int set_action(NODE **mset, NODE **aset, int action, int *num)
 	return size;
 }
 
+NODE *node_alloc()
+{
+	// reuse a node released by a previous set if possible
+	if(node_pool == NULL)
+		return malloc(sizeof(NODE));
+	NODE *n = node_pool;
+	node_pool = n->next;
+	return n;
+}
+
+void node_release(NODE *n)
+{
+	n->next = node_pool;
+	node_pool = n;
+}
+
 void set_add(NODE **set, CL *c)
 {
-	// add a classifier to a set
-	if(*set == NULL) {
-		*set = malloc(sizeof(NODE));
-		(*set)->cl = c;
-		(*set)->next = NULL;
+	// add a classifier to the start of a set
+	NODE *new = node_alloc();
+	new->cl = c;
+	new->next = *set;
+	*set = new;
+}
+
+void pop_add(CL *c)
+{
+	// if a duplicate exists just increase numerosity
+	if(MATCH_INDEX == 3 || (COND_TYPE == 1 && MATCH_INDEX != 0)) {
+		CL *d = (COND_TYPE == 1) ? sindex_duplicate(c) : trie_duplicate(c);
+		if(d != NULL) {
+			d->num += c->num;
+			pop_num_sum += c->num;
+			pstat_num(d, c->num);
+			cl_free(c);
+			return;
+		}
+		pop_insert(c);
+		return;
+	}
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		if(cl_duplicate(c, iter->cl)) {
+			iter->cl->num += c->num;
+			pop_num_sum += c->num;
+			pstat_num(iter->cl, c->num);
+			cl_free(c);
+			return;
+		}
+	}   
+	// new classifier
+	pop_insert(c);
+}
+
+_Bool pop_live(CL *c, int id)
+{
+	// whether c, last seen in slot id, is still in the population; c itself
+	// is not read as it may have been freed
+	return id >= 0 && id < pop_slots_cap && pop_slots[id] == c;
+}
+
+void pop_insert(CL *c)
+{
+	// adds a classifier known not to be a duplicate at the start of the list
+	c->stamp = pop_stamp++;
+	set_add(&pset, c);
+	pop_num++;
+	pop_num_sum += c->num;
+	pstat_num(c, c->num);
+	pop_index_add(c);
+}
+
+void pop_index_add(CL *c)
+{
+	// a new macro-classifier has entered the population
+	if(pop_ids_num > 0) {
+		pop_ids_num--;
+		c->id = pop_ids[pop_ids_num];
 	}
 	else {
-		NODE *new = malloc(sizeof(NODE));
-		new->cl = c;
-		new->next = *set;
-		*set = new;
+		c->id = pop_ids_next;
+		pop_ids_next++;
+	}
+	if(c->id >= pop_slots_cap) {
+		pop_slots_cap = (pop_slots_cap == 0) ? 1024 : pop_slots_cap * 2;
+		pop_slots = realloc(pop_slots, sizeof(CL*)*pop_slots_cap);
 	}
+	pop_slots[c->id] = c;
+	if(MATCH_CACHE_SIZE > 0)
+		mcache_add(c);
+	if(MATCH_DELTA)
+		dmatch_add(c);
+	if(COND_TYPE == 0 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		bindex_add(c);
+	if(MATCH_INDEX == 3)
+		trie_add(c);
+	if(COND_TYPE == 1)
+		imatch_add(c);
+	if(COND_TYPE == 1 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		sindex_add(c);
 }
 
-void pop_add(CL *c)
+void pop_index_del(CL *c)
 {
-	pop_num_sum++;
-	// adds the initial node in the list
-	if(pset == NULL) {
-		pset = malloc(sizeof(NODE));
-		pset->cl = c;
-		pset->next = NULL;
-		pop_num++;
+	// a macro-classifier is leaving the population
+	if(MATCH_CACHE_SIZE > 0)
+		mcache_del(c);
+	if(MATCH_DELTA)
+		dmatch_del(c);
+	if(COND_TYPE == 0 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		bindex_del(c);
+	if(MATCH_INDEX == 3)
+		trie_del(c);
+	if(COND_TYPE == 1)
+		imatch_del(c);
+	if(COND_TYPE == 1 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		sindex_del(c);
+	if(pop_ids_num == pop_ids_cap) {
+		pop_ids_cap = (pop_ids_cap == 0) ? 64 : pop_ids_cap * 2;
+		pop_ids = realloc(pop_ids, sizeof(int)*pop_ids_cap);
 	}
-	// adds a new node at the start of the list
-	else {
-		// if a duplicate exists just increase numerosity
-		for(NODE *iter = pset; iter != NULL; iter = iter->next) {
-			if(cl_duplicate(c, iter->cl)) {
-				iter->cl->num++;
-				cl_free(c);
-				return;
-			}
-		}   
-		// new classifier
-		NODE *new = malloc(sizeof(NODE));
-		new->next = pset;
-		new->cl = c;
-		pset = new;
-		pop_num++;
+	pop_ids[pop_ids_num] = c->id;
+	pop_ids_num++;
+	pop_slots[c->id] = NULL;
+	c->id = -1;
+}
+
+void pop_free()
+{
+	// frees the population and its matching structures
+	set_kill(&pset);
+	pop_num = 0;
+	pop_num_sum = 0;
+	free(pop_ids);
+	while(node_pool != NULL) {
+		NODE *n = node_pool;
+		node_pool = n->next;
+		free(n);
 	}
+	free(pop_slots);
+	free(par_match);
+	free(par_match_num);
+	free(pop_act_mark);
+	free(ord_buf);
+	pstat_free();
+	if(MATCH_CACHE_SIZE > 0)
+		mcache_free();
+	if(MATCH_DELTA)
+		dmatch_free();
+	if(COND_TYPE == 0 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		bindex_free();
+	if(MATCH_INDEX == 3)
+		trie_free();
+	if(COND_TYPE == 1)
+		imatch_free();
+	if(COND_TYPE == 1 && (MATCH_INDEX == 1 || MATCH_INDEX == 2))
+		sindex_free();
+	if(BATCH_SIZE > 1)
+		batch_free();
+	if(GA_QUEUE > 0)
+		ga_async_free();
 }
 
 void pop_del(NODE **kset)
@@ -193,15 +450,17 @@ void pop_del(NODE **kset)
 		if(sum > p) {
 			iter->cl->num--;
 			pop_num_sum--;
+			pstat_num(iter->cl, -1);
 			// macro classifier must be deleted
 			if(iter->cl->num == 0) {
+				pop_index_del(iter->cl);
 				pop_num--;
 				if(prev == NULL)
 					pset = iter->next;
 				else
 					prev->next = iter->next;
 				set_add(kset, iter->cl);
-				free(iter);
+				node_release(iter);
 			}
 			return;
 		}
@@ -259,20 +518,26 @@ void set_subsumption(NODE **set, int *size, int *num, NODE **kset)
 				s = c;
 		}
 	}
-	// subsume the more specific classifiers in the set
+	// subsume the more specific classifiers in the set; the victims are
+	// only marked, then the set and population are compacted once
 	if(s != NULL) {
-		iter = *set; 
-		while(iter != NULL) {
+		int victims = 0;
+		for(iter = *set; iter != NULL; iter = iter->next) {
 			CL *c = iter->cl;
-			iter = iter->next;
-			if(cond_general(&s->cond, &c->cond)) {
+			if(c->num > 0 && cond_general(&s->cond, &c->cond)) {
 				s->num += c->num;
+				pstat_num(s, c->num);
+				pstat_num(c, -c->num);
 				c->num = 0;
+				pop_index_del(c);
 				set_add(kset, c);
-				set_validate(set, size, num);
-				set_validate(&pset, &pop_num, &pop_num_sum);
+				victims++;
 			}
 		}
+		if(victims > 0) {
+			set_validate(set, size, num);
+			set_validate(&pset, &pop_num, &pop_num_sum);
+		}
 	}
 }
 
@@ -287,12 +552,12 @@ void set_validate(NODE **set, int *size, int *num)
 		if(iter->cl == NULL || iter->cl->num == 0) {
 			if(prev == NULL) {
 				*set = iter->next;
-				free(iter);
+				node_release(iter);
 				iter = *set;
 			}
 			else {
 				prev->next = iter->next;
-				free(iter);
+				node_release(iter);
 				iter = prev->next;
 			}
 		}
@@ -338,13 +603,42 @@ double set_mean_time(NODE **set, int num_sum)
 	return set_total_time(set) / num_sum;
 }
 
+void set_order(NODE **set)
+{
+	// puts a set found in slot or index order in the order of a scan of the
+	// population, which is that of the classifiers' entry stamps
+	int n = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		n++;
+	if(n == 0)
+		return;
+	if(n > ord_cap) {
+		ord_cap = n * 2;
+		ord_buf = realloc(ord_buf, sizeof(CL*)*ord_cap);
+	}
+	int i = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		ord_buf[i++] = iter->cl;
+	qsort(ord_buf, n, sizeof(CL*), set_order_cmp);
+	i = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		iter->cl = ord_buf[i++];
+}
+
+int set_order_cmp(const void *a, const void *b)
+{
+	long s1 = (*(CL**)a)->stamp;
+	long s2 = (*(CL**)b)->stamp;
+	return (s1 > s2) - (s1 < s2);
+}
+
 void set_free(NODE **set)
 {
 	// frees the set only, not the classifiers
 	NODE *iter = *set;
 	while(iter != NULL) {
 		*set = iter->next;
-		free(iter);
+		node_release(iter);
 		iter = *set;
 	}
 }
@@ -356,7 +650,7 @@ void set_kill(NODE **set)
 	while(iter != NULL) {
 		cl_free(iter->cl);
 		*set = iter->next;
-		free(iter);
+		node_release(iter);
 		iter = *set;
 	}
 }
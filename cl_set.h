@@ -25,6 +25,12 @@ void pop_init();
 void pop_add(CL *c);
 void pop_del(NODE **kset);
 void pop_enforce_limit(NODE **kset);
+void pop_free();
+void pop_index_del(CL *c);
+void pop_insert(CL *c);
+_Bool pop_live(CL *c, int id);
+void pop_match(NODE **mset, char *state, double *dstate);
+void pop_scan(NODE **mset, char *state);
 double set_mean_time(NODE **set, int num_sum);
 double set_total_fit(NODE **set);
 double set_total_time(NODE **set);
@@ -32,8 +38,11 @@ int set_action(NODE **mset, NODE **aset, int action, int *num);
 void set_add(NODE **set, CL *c);
 void set_free(NODE **set);
 void set_kill(NODE **set);
-void set_match(NODE **mset, char *state, int time, NODE **kset);
+void set_match(NODE **mset, char *state, double *dstate, int time, 
+		NODE **kset);
+void set_order(NODE **set);
 void set_print(NODE *set);
+void set_subsumption(NODE **set, int *size, int *num, NODE **kset);
 void set_times(NODE **set, int time);
 void set_validate(NODE **set, int *size, int *num);
 void set_update(NODE **set, int *size, int *num, double max_p, double r,
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * Classifier real-valued interval conditions module.
+ *
+ * A classifier matches a real-valued environment state if, and only if, each
+ * input lies within the lower and upper bound held for it, i.e., the state is
+ * inside the condition's hyperrectangle. Covering and random initialisation
+ * place each bound up to COND_S0 from the input (or a random centre in
+ * [-1,1], the range the problems scale their inputs to) and mutation moves a
+ * bound by up to COND_M0. Bounds are stored as floats and inputs are
+ * converted to float before comparing so that matching here agrees with the
+ * vectorised matching of the imatch module.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cond_interval.h"
+
+void ivl_order(COND *cond);
+
+void ivl_init(COND *cond)
+{
+	cond->lo = malloc(sizeof(float)*dstate_length);
+	cond->hi = malloc(sizeof(float)*dstate_length);
+}
+
+void ivl_copy(COND *to, COND *from)
+{
+	memcpy(to->lo, from->lo, sizeof(float)*dstate_length);
+	memcpy(to->hi, from->hi, sizeof(float)*dstate_length);
+}
+
+void ivl_free(COND *cond)
+{
+	free(cond->lo);
+	free(cond->hi);
+}
+
+void ivl_order(COND *cond)
+{
+	// a lower bound moved above its upper bound swaps with it
+	for(int i = 0; i < dstate_length; i++) {
+		if(cond->lo[i] > cond->hi[i]) {
+			float help = cond->lo[i];
+			cond->lo[i] = cond->hi[i];
+			cond->hi[i] = help;
+		}
+	}
+}
+
+_Bool ivl_match(COND *cond, double *dstate)
+{
+	cond->m = ivl_match_bounds(cond->lo, cond->hi, dstate);
+	return cond->m;
+}
+
+_Bool ivl_match_bounds(float *lo, float *hi, double *dstate)
+{
+	for(int i = 0; i < dstate_length; i++) {
+		float x = (float)dstate[i];
+		if(x < lo[i] || x > hi[i])
+			return false;
+	}
+	return true;
+}
+
+void ivl_rand(COND *cond)
+{
+	for(int i = 0; i < dstate_length; i++) {
+		double c = (drand() * 2.0) - 1.0;
+		cond->lo[i] = (float)(c - drand() * COND_S0);
+		cond->hi[i] = (float)(c + drand() * COND_S0);
+	}
+}
+
+void ivl_cover(COND *cond, double *dstate)
+{
+	// rounding to float preserves lo <= x <= hi so the state is matched
+	for(int i = 0; i < dstate_length; i++) {
+		cond->lo[i] = (float)(dstate[i] - drand() * COND_S0);
+		cond->hi[i] = (float)(dstate[i] + drand() * COND_S0);
+	}
+}
+
+_Bool ivl_crossover(COND *cond1, COND *cond2)
+{
+	// two point crossover over the bounds, taken lower then upper per input
+	_Bool changed = false;
+	if(drand() < P_CROSSOVER) {
+		int len = dstate_length * 2;
+		int p1 = irand(0, len);
+		int p2 = irand(0, len)+1;
+		if(p1 > p2) {
+			int help = p1;
+			p1 = p2;
+			p2 = help;
+		}
+		else if(p1 == p2) {
+			p2++;
+		}
+		for(int i = p1; i < p2 && i < len; i++) {
+			float *b1 = (i%2 == 0) ? &cond1->lo[i/2] : &cond1->hi[i/2];
+			float *b2 = (i%2 == 0) ? &cond2->lo[i/2] : &cond2->hi[i/2];
+			if(*b1 != *b2) {
+				changed = true;
+				float help = *b1;
+				*b1 = *b2;
+				*b2 = help;
+			}
+		}
+		if(changed) {
+			ivl_order(cond1);
+			ivl_order(cond2);
+		}
+	}
+	return changed;
+}
+
+_Bool ivl_mutate(COND *cond)
+{
+	_Bool mod = false;
+	for(int i = 0; i < dstate_length; i++) {
+		if(drand() < P_MUTATION) {
+			cond->lo[i] += (float)(((drand() * 2.0) - 1.0) * COND_M0);
+			mod = true;
+		}
+		if(drand() < P_MUTATION) {
+			cond->hi[i] += (float)(((drand() * 2.0) - 1.0) * COND_M0);
+			mod = true;
+		}
+	}
+	if(mod)
+		ivl_order(cond);
+	return mod;
+}
+
+_Bool ivl_general(COND *cond1, COND *cond2)
+{
+	// returns true if cond1 is more general than cond2: its hyperrectangle
+	// contains cond2's and is not the same
+	_Bool larger = false;
+	for(int i = 0; i < dstate_length; i++) {
+		if(cond1->lo[i] > cond2->lo[i] || cond1->hi[i] < cond2->hi[i])
+			return false;
+		if(cond1->lo[i] < cond2->lo[i] || cond1->hi[i] > cond2->hi[i])
+			larger = true;
+	}
+	return larger;
+}
+
+double ivl_spec(COND *cond)
+{
+	// one minus the mean fraction of each input's range [-1,1] matched
+	double w = 0.0;
+	for(int i = 0; i < dstate_length; i++)
+		w += fmax(fmin(cond->hi[i], 1.0) - fmax(cond->lo[i], -1.0), 0.0);
+	return 1.0 - w / (2.0 * dstate_length);
+}
+
+_Bool ivl_duplicate(COND *cond1, COND *cond2)
+{
+	for(int i = 0; i < dstate_length; i++) {
+		if(cond1->lo[i] != cond2->lo[i] || cond1->hi[i] != cond2->hi[i])
+			return false;
+	}
+	return true;
+}
+
+size_t ivl_save(COND *cond, char *buf)
+{
+	size_t s = sizeof(float)*dstate_length;
+	if(buf != NULL) {
+		memcpy(buf, cond->lo, s);
+		memcpy(buf+s, cond->hi, s);
+	}
+	return s*2;
+}
+
+size_t ivl_load(COND *cond, char *buf)
+{
+	size_t s = sizeof(float)*dstate_length;
+	memcpy(cond->lo, buf, s);
+	memcpy(cond->hi, buf+s, s);
+	return s*2;
+}
+
+void ivl_print(COND *cond)
+{
+	for(int i = 0; i < dstate_length; i++)
+		printf("(%.4f,%.4f) ", cond->lo[i], cond->hi[i]);
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+_Bool ivl_crossover(COND *cond1, COND *cond2);
+_Bool ivl_duplicate(COND *cond1, COND *cond2);
+_Bool ivl_general(COND *cond1, COND *cond2);
+_Bool ivl_match(COND *cond, double *dstate);
+_Bool ivl_match_bounds(float *lo, float *hi, double *dstate);
+_Bool ivl_mutate(COND *cond);
+double ivl_spec(COND *cond);
+size_t ivl_load(COND *cond, char *buf);
+size_t ivl_save(COND *cond, char *buf);
+void ivl_copy(COND *to, COND *from);
+void ivl_cover(COND *cond, double *dstate);
+void ivl_free(COND *cond);
+void ivl_init(COND *cond);
+void ivl_print(COND *cond);
+void ivl_rand(COND *cond);
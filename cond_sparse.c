@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * Classifier sparse ternary conditions module.
+ *
+ * For long inputs of which a classifier specifies few bits, a condition is
+ * kept as the sorted list of its specified alleles, each stored as the bit's
+ * position times two plus its value, rather than as a string. Matching reads
+ * only the input at those positions, and covering, random initialisation and
+ * mutation pick the positions they change by drawing geometrically
+ * distributed gaps, so their cost follows the number of alleles specified or
+ * changed rather than the input length. Conditions are saved as strings so
+ * that the saved format does not depend on the number specified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cond_sparse.h"
+
+int sparse_skip(double p);
+void sparse_push(COND *cond, int a);
+
+void sparse_init(COND *cond)
+{
+	cond->sp = NULL;
+	cond->spec = 0;
+	cond->sp_cap = 0;
+}
+
+void sparse_free(COND *cond)
+{
+	free(cond->sp);
+}
+
+void sparse_copy(COND *to, COND *from)
+{
+	to->spec = 0;
+	for(int i = 0; i < from->spec; i++)
+		sparse_push(to, from->sp[i]);
+}
+
+void sparse_push(COND *cond, int a)
+{
+	// appends an allele, which must follow those in the list
+	if(cond->spec == cond->sp_cap) {
+		cond->sp_cap = (cond->sp_cap == 0) ? 8 : cond->sp_cap * 2;
+		cond->sp = realloc(cond->sp, sizeof(int)*cond->sp_cap);
+	}
+	cond->sp[cond->spec++] = a;
+}
+
+int sparse_skip(double p)
+{
+	// number of positions passed over before the next one chosen with
+	// probability p
+	if(p >= 1.0)
+		return 0;
+	if(p <= 0.0)
+		return state_length;
+	double u = 1.0 - drand();
+	double skip = floor(log(u) / log(1.0 - p));
+	return (skip < state_length) ? (int)skip : state_length;
+}
+
+_Bool sparse_match(COND *cond, char *state)
+{
+	for(int i = 0; i < cond->spec; i++) {
+		int a = cond->sp[i];
+		if(state[a/2] != '0' + a%2) {
+			cond->m = false;
+			return false;
+		}
+	}
+	cond->m = true;
+	return true;
+}
+
+void sparse_rand(COND *cond)
+{
+	cond->spec = 0;
+	for(int i = sparse_skip(1.0 - P_DONTCARE); i < state_length; 
+			i += 1 + sparse_skip(1.0 - P_DONTCARE))
+		sparse_push(cond, i*2 + (drand() < 0.5 ? 0 : 1));
+}
+
+void sparse_cover(COND *cond, char *state)
+{
+	cond->spec = 0;
+	for(int i = sparse_skip(1.0 - P_DONTCARE); i < state_length; 
+			i += 1 + sparse_skip(1.0 - P_DONTCARE))
+		sparse_push(cond, i*2 + (state[i] == '1'));
+}
+
+_Bool sparse_crossover(COND *cond1, COND *cond2)
+{
+	// two point crossover: the alleles in [p1,p2) are exchanged
+	_Bool changed = false;
+	if(drand() < P_CROSSOVER) {
+		int p1 = irand(0, state_length);
+		int p2 = irand(0, state_length)+1;
+		if(p1 > p2) {
+			int help = p1;
+			p1 = p2;
+			p2 = help;
+		}
+		else if(p1 == p2) {
+			p2++;
+		}
+		// the range of each list between the two points
+		int s1 = 0, e1, s2 = 0, e2;
+		while(s1 < cond1->spec && cond1->sp[s1]/2 < p1)
+			s1++;
+		for(e1 = s1; e1 < cond1->spec && cond1->sp[e1]/2 < p2; e1++);
+		while(s2 < cond2->spec && cond2->sp[s2]/2 < p1)
+			s2++;
+		for(e2 = s2; e2 < cond2->spec && cond2->sp[e2]/2 < p2; e2++);
+		changed = (e1 - s1 != e2 - s2) || (e1 > s1 && memcmp(&cond1->sp[s1], 
+					&cond2->sp[s2], sizeof(int)*(e1 - s1)) != 0);
+		if(changed) {
+			COND c1, c2;
+			sparse_init(&c1);
+			sparse_init(&c2);
+			for(int i = 0; i < s1; i++)
+				sparse_push(&c1, cond1->sp[i]);
+			for(int i = s2; i < e2; i++)
+				sparse_push(&c1, cond2->sp[i]);
+			for(int i = e1; i < cond1->spec; i++)
+				sparse_push(&c1, cond1->sp[i]);
+			for(int i = 0; i < s2; i++)
+				sparse_push(&c2, cond2->sp[i]);
+			for(int i = s1; i < e1; i++)
+				sparse_push(&c2, cond1->sp[i]);
+			for(int i = e2; i < cond2->spec; i++)
+				sparse_push(&c2, cond2->sp[i]);
+			sparse_free(cond1);
+			sparse_free(cond2);
+			cond1->sp = c1.sp;
+			cond1->spec = c1.spec;
+			cond1->sp_cap = c1.sp_cap;
+			cond2->sp = c2.sp;
+			cond2->spec = c2.spec;
+			cond2->sp_cap = c2.sp_cap;
+		}
+	}
+	return changed;
+}
+
+_Bool sparse_mutate(COND *cond, char *state)
+{
+	// each position is flipped between DONT_CARE and the state's value
+	// with probability P_MUTATION; the chosen positions are merged with
+	// the list
+	int i = sparse_skip(P_MUTATION);
+	if(i >= state_length)
+		return false;
+	COND c;
+	sparse_init(&c);
+	int j = 0;
+	while(i < state_length) {
+		while(j < cond->spec && cond->sp[j]/2 < i)
+			sparse_push(&c, cond->sp[j++]);
+		if(j < cond->spec && cond->sp[j]/2 == i)
+			j++;
+		else
+			sparse_push(&c, i*2 + (state[i] == '1'));
+		i += 1 + sparse_skip(P_MUTATION);
+	}
+	while(j < cond->spec)
+		sparse_push(&c, cond->sp[j++]);
+	sparse_free(cond);
+	cond->sp = c.sp;
+	cond->spec = c.spec;
+	cond->sp_cap = c.sp_cap;
+	return true;
+}
+
+_Bool sparse_general(COND *cond1, COND *cond2)
+{
+	// returns true if cond1 is more general than cond2: it must specify
+	// fewer bits, all of which cond2 specifies with the same values
+	if(cond1->spec >= cond2->spec)
+		return false;
+	int j = 0;
+	for(int i = 0; i < cond1->spec; i++) {
+		while(j < cond2->spec && cond2->sp[j] < cond1->sp[i])
+			j++;
+		if(j == cond2->spec || cond2->sp[j] != cond1->sp[i])
+			return false;
+	}
+	return true;
+}
+
+_Bool sparse_duplicate(COND *cond1, COND *cond2)
+{
+	return cond1->spec == cond2->spec && (cond1->spec == 0 
+			|| memcmp(cond1->sp, cond2->sp, sizeof(int)*cond1->spec) == 0);
+}
+
+size_t sparse_save(COND *cond, char *buf)
+{
+	if(buf != NULL) {
+		memset(buf, DONT_CARE, sizeof(char)*state_length);
+		for(int i = 0; i < cond->spec; i++)
+			buf[cond->sp[i]/2] = '0' + cond->sp[i]%2;
+	}
+	return sizeof(char)*state_length;
+}
+
+size_t sparse_load(COND *cond, char *buf)
+{
+	cond->spec = 0;
+	for(int i = 0; i < state_length; i++) {
+		if(buf[i] != DONT_CARE)
+			sparse_push(cond, i*2 + (buf[i] == '1'));
+	}
+	return sizeof(char)*state_length;
+}
+
+void sparse_print(COND *cond)
+{
+	for(int i = 0; i < cond->spec; i++)
+		printf("%d:%d ", cond->sp[i]/2, cond->sp[i]%2);
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+_Bool sparse_crossover(COND *cond1, COND *cond2);
+_Bool sparse_duplicate(COND *cond1, COND *cond2);
+_Bool sparse_general(COND *cond1, COND *cond2);
+_Bool sparse_match(COND *cond, char *state);
+_Bool sparse_mutate(COND *cond, char *state);
+size_t sparse_load(COND *cond, char *buf);
+size_t sparse_save(COND *cond, char *buf);
+void sparse_copy(COND *to, COND *from);
+void sparse_cover(COND *cond, char *state);
+void sparse_free(COND *cond);
+void sparse_init(COND *cond);
+void sparse_print(COND *cond);
+void sparse_rand(COND *cond);
@@ -24,6 +24,14 @@
  * DONT_CARE symbol, which matches a logical '1' or '0' for that bit.  Provides
  * functions to generate random or matching conditions, to mutate a condition,
  * and print it, etc.
+ *
+ * Each condition also keeps its specificity and the string packed into care
+ * and value bit masks, repacked whenever the string changes, so that
+ * generality can be tested a word at a time.
+ *
+ * When COND_TYPE selects interval conditions each function defers to the
+ * cond_interval module, which matches the real-valued state instead, and
+ * when it selects sparse conditions to the cond_sparse module.
  */
 
 #include <stdio.h>
@@ -34,31 +42,82 @@
 #include "cons.h"
 #include "random.h"
 #include "cl.h"
+#include "cond_interval.h"
+#include "cond_sparse.h"
+#include "kern.h"
+
+void cond_pack(COND *cond);
 
 void cond_init(COND *cond)
 {
+	if(COND_TYPE == 1) {
+		ivl_init(cond);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_init(cond);
+		return;
+	}
+	int words = (state_length + 63) / 64;
 	cond->string = malloc(sizeof(char)*state_length);
+	cond->care = calloc(words, sizeof(uint64_t));
+	cond->val = calloc(words, sizeof(uint64_t));
+	cond->spec = 0;
 }
 
 void cond_copy(COND *to, COND *from)
 {
+	if(COND_TYPE == 1) {
+		ivl_copy(to, from);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_copy(to, from);
+		return;
+	}
+	int words = (state_length + 63) / 64;
 	memcpy(to->string, from->string, sizeof(char)*state_length);
-}                              
- 
-_Bool cond_match(COND *cond, char *state)
+	memcpy(to->care, from->care, sizeof(uint64_t)*words);
+	memcpy(to->val, from->val, sizeof(uint64_t)*words);
+	to->spec = from->spec;
+}
+
+void cond_pack(COND *cond)
 {
+	int words = (state_length + 63) / 64;
+	memset(cond->care, 0, sizeof(uint64_t)*words);
+	memset(cond->val, 0, sizeof(uint64_t)*words);
+	cond->spec = 0;
 	for(int i = 0; i < state_length; i++) {
-		if(cond->string[i] != DONT_CARE && cond->string[i] != state[i]) {
-			cond->m = false;
-			return false;
+		if(cond->string[i] != DONT_CARE) {
+			cond->care[i/64] |= (uint64_t)1 << (i%64);
+			cond->spec++;
+			if(cond->string[i] == '1')
+				cond->val[i/64] |= (uint64_t)1 << (i%64);
 		}
 	}
-	cond->m = true;
-	return true;
+}                              
+ 
+_Bool cond_match(COND *cond, char *state, double *dstate)
+{
+	if(COND_TYPE == 1)
+		return ivl_match(cond, dstate);
+	if(COND_TYPE == 2)
+		return sparse_match(cond, state);
+	cond->m = kern_match(cond->string, state);
+	return cond->m;
 }
  
 void cond_rand(COND *cond)
 {
+	if(COND_TYPE == 1) {
+		ivl_rand(cond);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_rand(cond);
+		return;
+	}
 	for(int i = 0; i < state_length; i++) {
 		if(drand() < P_DONTCARE) 
 			cond->string[i] = DONT_CARE;
@@ -69,20 +128,34 @@ void cond_rand(COND *cond)
 				cond->string[i] = '1';
 		}
 	}
+	cond_pack(cond);
 }
 
-void cond_cover(COND *cond, char *state)
+void cond_cover(COND *cond, char *state, double *dstate)
 {
+	if(COND_TYPE == 1) {
+		ivl_cover(cond, dstate);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_cover(cond, state);
+		return;
+	}
 	for(int i = 0; i < state_length; i++) {
 		if(drand() < P_DONTCARE)
 			cond->string[i] = DONT_CARE;
 		else
 			cond->string[i] = state[i];
 	}
+	cond_pack(cond);
 }
                
 _Bool cond_crossover(COND *cond1, COND *cond2) 
 {
+	if(COND_TYPE == 1)
+		return ivl_crossover(cond1, cond2);
+	if(COND_TYPE == 2)
+		return sparse_crossover(cond1, cond2);
 	// two point crossover
 	_Bool changed = false;
 	if(drand() < P_CROSSOVER) {
@@ -111,6 +184,8 @@ _Bool cond_crossover(COND *cond1, COND *cond2)
 		if(changed) {
 			strncpy(cond1->string, cc1, state_length);
 			strncpy(cond2->string, cc2, state_length);
+			cond_pack(cond1);
+			cond_pack(cond2);
 		}
 	}
 	return changed;
@@ -118,6 +193,10 @@ _Bool cond_crossover(COND *cond1, COND *cond2)
                     
 _Bool cond_mutate(COND *cond, char *state)
 {
+	if(COND_TYPE == 1)
+		return ivl_mutate(cond);
+	if(COND_TYPE == 2)
+		return sparse_mutate(cond, state);
 	_Bool mod = false;
 	for(int i = 0; i < state_length; i++) {
 		if(drand() < P_MUTATION) {
@@ -128,38 +207,91 @@ _Bool cond_mutate(COND *cond, char *state)
 			mod = true;
 		}
 	}
+	if(mod)
+		cond_pack(cond);
 	return mod;
 }
 
 _Bool cond_general(COND *cond1, COND *cond2)
 {
-	// returns true if cond1 is more general than cond2
-	_Bool gen = false;
-	for(int i = 0; i < state_length; i++) {
-		if(cond1->string[i] != DONT_CARE && cond1->string[i] != cond2->string[i])
+	if(COND_TYPE == 1)
+		return ivl_general(cond1, cond2);
+	if(COND_TYPE == 2)
+		return sparse_general(cond1, cond2);
+	// returns true if cond1 is more general than cond2: it must specify
+	// fewer bits, all of which cond2 specifies with the same values
+	if(cond1->spec >= cond2->spec)
+		return false;
+	int words = (state_length + 63) / 64;
+	for(int i = 0; i < words; i++) {
+		uint64_t care = cond1->care[i];
+		if((care & ~cond2->care[i]) != 0 
+				|| ((cond1->val[i] ^ cond2->val[i]) & care) != 0)
 			return false;
-		else if(cond1->string[i] != cond2->string[i])
-			gen = true;
 	}
-	return gen;
+	return true;
 }
  
 _Bool cond_duplicate(COND *cond1, COND *cond2)
 {
+	if(COND_TYPE == 1)
+		return ivl_duplicate(cond1, cond2);
+	if(COND_TYPE == 2)
+		return sparse_duplicate(cond1, cond2);
 	for(int i = 0; i < state_length; i++) {
 		if(cond1->string[i] != cond2->string[i])
 			return false;
 	}
-	return false;
+	return true;
+}
+
+size_t cond_save(COND *cond, char *buf)
+{
+	if(COND_TYPE == 1)
+		return ivl_save(cond, buf);
+	if(COND_TYPE == 2)
+		return sparse_save(cond, buf);
+	if(buf != NULL)
+		memcpy(buf, cond->string, sizeof(char)*state_length);
+	return sizeof(char)*state_length;
+}
+
+size_t cond_load(COND *cond, char *buf)
+{
+	if(COND_TYPE == 1)
+		return ivl_load(cond, buf);
+	if(COND_TYPE == 2)
+		return sparse_load(cond, buf);
+	memcpy(cond->string, buf, sizeof(char)*state_length);
+	cond_pack(cond);
+	return sizeof(char)*state_length;
 }
 
 void cond_free(COND *cond)
 {
+	if(COND_TYPE == 1) {
+		ivl_free(cond);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_free(cond);
+		return;
+	}
 	free(cond->string);
+	free(cond->care);
+	free(cond->val);
 }
  
 void cond_print(COND *cond)
 {
+	if(COND_TYPE == 1) {
+		ivl_print(cond);
+		return;
+	}
+	if(COND_TYPE == 2) {
+		sparse_print(cond);
+		return;
+	}
 	for(int i = 0; i < state_length; i++)
 		printf("%c", cond->string[i]);
 }
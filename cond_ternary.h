@@ -15,7 +15,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
+
 typedef struct COND {
 	char *string;
 	_Bool m;
+	uint64_t *care; // bits of the string that are not DONT_CARE
+	uint64_t *val; // the bits that are '1'
+	int spec; // number of bits that are not DONT_CARE
+	int *sp; // sorted specified alleles as position*2+value (COND_TYPE 2)
+	int sp_cap;
+	float *lo; // interval lower bound per real input (COND_TYPE 1)
+	float *hi; // interval upper bound per real input
 } COND;
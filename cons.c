@@ -21,7 +21,7 @@
  *
  * Reads in the global constants from cons.txt. The number of trials and number
  * of experiments to perform can be overridden by passing command line
- * arguments.
+ * arguments, and any constant by constants_override (used by sweeps).
  */
 
 #include <stdio.h>
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include "cons.h"
+#include "xcs.h"
 
 #define MAXLEN 127
 typedef char *pchar;
@@ -54,49 +55,76 @@ pchar getvalue(pchar name);
 
 psection head;
 psection current;
+pnv overrides; // values used in place of those in cons.txt
  
-void constants_init(int argc, char **argv)
+void constants_init(int argc, char **argv, XCS_PARAMS *p)
 {
+	// experiment settings are kept here; learner parameters go to p
+	xcs_default_params(p);
 	init_config("cons.txt");
-	POP_SIZE = atoi(getvalue("POP_SIZE"));
-	if(strcmp(getvalue("POP_INIT"), "false") == 0)
-		POP_INIT = false;
-	else
-		POP_INIT = true;
+	p->pop_size = atoi(getvalue("POP_SIZE"));
+	p->pop_init = (strcmp(getvalue("POP_INIT"), "false") != 0);
 	NUM_EXPERIMENTS = atoi(getvalue("NUM_EXPERIMENTS"));
 	MAX_TRIALS = atoi(getvalue("MAX_TRIALS"));
-	P_CROSSOVER = atof(getvalue("P_CROSSOVER"));
-	P_MUTATION = atof(getvalue("P_MUTATION"));
-	THETA_SUB = atof(getvalue("THETA_SUB"));
-	EPS_0 = atof(getvalue("EPS_0"));
-	DELTA = atof(getvalue("DELTA"));
-	THETA_DEL = atof(getvalue("THETA_DEL"));
-	THETA_GA = atof(getvalue("THETA_GA"));
-	BETA = atof(getvalue("BETA"));
-	ALPHA = atof(getvalue("ALPHA")); 
-	NU = atof(getvalue("NU"));
-	GAMMA = atof(getvalue("GAMMA"));
-	P_DONTCARE = atof(getvalue("P_DONTCARE"));
-	DONT_CARE = '#';
-	INIT_PREDICTION = atof(getvalue("INIT_PREDICTION"));
-	INIT_FITNESS = atof(getvalue("INIT_FITNESS"));
-	INIT_ERROR = atof(getvalue("INIT_ERROR"));
-	ERR_REDUC = atof(getvalue("ERR_REDUC"));
-	FIT_REDUC = atof(getvalue("FIT_REDUC"));
+	p->p_crossover = atof(getvalue("P_CROSSOVER"));
+	p->p_mutation = atof(getvalue("P_MUTATION"));
+	p->theta_sub = atof(getvalue("THETA_SUB"));
+	p->eps_0 = atof(getvalue("EPS_0"));
+	p->delta = atof(getvalue("DELTA"));
+	p->theta_del = atof(getvalue("THETA_DEL"));
+	p->theta_ga = atof(getvalue("THETA_GA"));
+	p->theta_mna = atoi(getvalue("THETA_MNA"));
+	p->ga_queue = atoi(getvalue("GA_QUEUE"));
+	p->ga_stale = atoi(getvalue("GA_STALE"));
+	p->beta = atof(getvalue("BETA"));
+	p->alpha = atof(getvalue("ALPHA")); 
+	p->nu = atof(getvalue("NU"));
+	p->gamma = atof(getvalue("GAMMA"));
+	p->p_dontcare = atof(getvalue("P_DONTCARE"));
+	p->cond_type = atoi(getvalue("COND_TYPE"));
+	p->cond_s0 = atof(getvalue("COND_S0"));
+	p->cond_m0 = atof(getvalue("COND_M0"));
+	p->init_prediction = atof(getvalue("INIT_PREDICTION"));
+	p->init_fitness = atof(getvalue("INIT_FITNESS"));
+	p->init_error = atof(getvalue("INIT_ERROR"));
+	p->err_reduc = atof(getvalue("ERR_REDUC"));
+	p->fit_reduc = atof(getvalue("FIT_REDUC"));
 	TELETRANSPORTATION = atoi(getvalue("TELETRANSPORTATION"));
-	if(strcmp(getvalue("GA_SUBSUMPTION"), "false") == 0)
-		GA_SUBSUMPTION = false;
-	else
-		GA_SUBSUMPTION = true;
-	if(strcmp(getvalue("ACTION_SUBSUMPTION"), "false") == 0)
-		ACTION_SUBSUMPTION = false;
-	else
-		ACTION_SUBSUMPTION = true;
+	p->ga_subsumption = (strcmp(getvalue("GA_SUBSUMPTION"), "false") != 0);
+	p->action_subsumption = (strcmp(getvalue("ACTION_SUBSUMPTION"), "false") != 0);
 	PERF_AVG_TRIALS = atoi(getvalue("PERF_AVG_TRIALS"));
-	XCSF_X0 = atof(getvalue("XCSF_X0"));
-	XCSF_ETA = atof(getvalue("XCSF_ETA"));
-	muEPS_0 = atof(getvalue("muEPS_0"));
-	NUM_MU = atoi(getvalue("NUM_MU"));
+	PERF_CONSOLE = atoi(getvalue("PERF_CONSOLE"));
+	PERF_BINARY = (strcmp(getvalue("PERF_BINARY"), "false") != 0);
+	PERF_POP_STATS = (strcmp(getvalue("PERF_POP_STATS"), "false") != 0);
+	p->xcsf_x0 = atof(getvalue("XCSF_X0"));
+	p->xcsf_eta = atof(getvalue("XCSF_ETA"));
+	p->mu_eps_0 = atof(getvalue("muEPS_0"));
+	p->num_mu = atoi(getvalue("NUM_MU"));
+	p->match_cache_size = atoi(getvalue("MATCH_CACHE_SIZE"));
+	p->match_delta = (strcmp(getvalue("MATCH_DELTA"), "false") != 0);
+	p->match_index = atoi(getvalue("MATCH_INDEX"));
+	p->num_threads = atoi(getvalue("NUM_THREADS"));
+	p->par_match_min = atoi(getvalue("PAR_MATCH_MIN"));
+	p->par_pa_min = atoi(getvalue("PAR_PA_MIN"));
+	p->batch_size = atoi(getvalue("BATCH_SIZE"));
+	INFER_VERIFY = atoi(getvalue("INFER_VERIFY"));
+	p->infer_table_bits = atoi(getvalue("INFER_TABLE_BITS"));
+	ISLANDS = atoi(getvalue("ISLANDS"));
+	MIGRATE_EVERY = atoi(getvalue("MIGRATE_EVERY"));
+	MIGRATE_NUM = atoi(getvalue("MIGRATE_NUM"));
+	MIGRATE_SELECT = atoi(getvalue("MIGRATE_SELECT"));
+	MIGRATE_TOPOLOGY = atoi(getvalue("MIGRATE_TOPOLOGY"));
+	ISLAND_MERGE = atoi(getvalue("ISLAND_MERGE"));
+	ISLAND_CONDENSE = atoi(getvalue("ISLAND_CONDENSE"));
+	ISLAND_TARGET = atof(getvalue("ISLAND_TARGET"));
+	HOGWILD = atoi(getvalue("HOGWILD"));
+	HOGWILD_ROUND = atoi(getvalue("HOGWILD_ROUND"));
+	p->serve_readers = atoi(getvalue("SERVE_READERS"));
+	SERVE_PUBLISH = atoi(getvalue("SERVE_PUBLISH"));
+	SERVE_QUEUE = atoi(getvalue("SERVE_QUEUE"));
+	snprintf(SWEEP, sizeof(SWEEP), "%s", getvalue("SWEEP"));
+	SWEEP_WORKERS = atoi(getvalue("SWEEP_WORKERS"));
+	SWEEP_SAMPLES = atoi(getvalue("SWEEP_SAMPLES"));
 	tidyup();
 	// override cons.txt with command line arguments
 	if(argc > 3) {
@@ -106,6 +134,40 @@ void constants_init(int argc, char **argv)
 	}      
 }
 
+void constants_override(pchar name, pchar value)
+{
+	// replaces a constant in later reads; a NULL name removes all overrides
+	if(name == NULL) {
+		while(overrides != NULL) {
+			pnv next = overrides->next;
+			free(overrides->name);
+			free(overrides->value);
+			free(overrides);
+			overrides = next;
+		}
+		return;
+	}
+	pnv nv = malloc(sizeof(struct nv));
+	nv->name = strdup(name);
+	nv->value = strdup(value);
+	nv->next = overrides;
+	overrides = nv;
+}
+
+_Bool constants_exists(pchar name)
+{
+	init_config("cons.txt");
+	if(head == NULL)
+		return false;
+	_Bool found = false;
+	for(pnv nv = current->nvlist; nv != NULL; nv = nv->next) {
+		if(strcmp(name, nv->name) == 0)
+			found = true;
+	}
+	tidyup();
+	return found;
+}
+
 void trim(pchar s) // Remove tabs/spaces/lf/cr  both ends
 {
 	size_t i=0,j;
@@ -190,6 +252,10 @@ psection findsection(pchar sectionname) {
 }
 
 pchar getvalue(pchar name) {
+	for(pnv nv = overrides; nv != NULL; nv = nv->next) {
+		if(strcmp(name, nv->name) == 0)
+			return nv->value;
+	}
 	pchar result = NULL;
 	pnv currnv = current->nvlist;
 	while(currnv) {
@@ -21,13 +21,26 @@
  * XCS global constants; read from cons.txt
  */
 
-void constants_init(int argc, char **argv);
+struct XCS_PARAMS;
+void constants_init(int argc, char **argv, struct XCS_PARAMS *p);
+void constants_override(char *name, char *value);
+_Bool constants_exists(char *name);
+
+// storage of the classifier parameters and prediction weights (FLOAT=1)
+#ifdef FLOAT_STORAGE
+typedef float REAL;
+#else
+typedef double REAL;
+#endif
 
 // experiment parameters
 _Bool POP_INIT; // population initially empty or filled with random conditions
 int MAX_TRIALS; // number of problem instances to run in one experiment
 int NUM_EXPERIMENTS; // number of experiments to run
 int PERF_AVG_TRIALS; // number of problem instances to average performance output
+int PERF_CONSOLE; // minimum milliseconds between performance lines on the console
+_Bool PERF_BINARY; // whether performance is also written in binary columns
+_Bool PERF_POP_STATS; // whether population statistics are also written
 int POP_SIZE; // maximum number of macro-classifiers in the population
 // classifier parameters
 double ALPHA; // linear coefficient used in calculating classifier accuracy
@@ -46,12 +59,18 @@ int TELETRANSPORTATION; // num steps to reset a multi-step problem if goal not f
 double P_CROSSOVER; // probability of applying crossover (for hyperrectangles)
 double P_MUTATION; // probability of mutation occuring per allele
 double THETA_GA; // average match set time between GA invocations
+int THETA_MNA; // actions a match set must advocate before covering stops (0 = all)
+int GA_QUEUE; // GA runs outstanding on a separate thread (0 = synchronous GA)
+int GA_STALE; // time steps after which a queued GA run must be applied (0 = no bound)
 // self-adaptive mutation parameters
 double muEPS_0; // minimum value of a self-adaptive mutation rate
 int NUM_MU; // number of self-adaptive mutation rates
 // classifier condition parameters
 char DONT_CARE; // symbol used for ternary condition
 double P_DONTCARE; // per allele probability of don't care in covering or random init
+int COND_TYPE; // 0 = ternary over the binary input, 1 = intervals over the real input, 2 = sparse ternary
+double COND_S0; // maximum distance of an interval bound from the input in covering
+double COND_M0; // maximum change of an interval bound by mutation
 // prediction parameters
 double INIT_PREDICTION; // initial prediction value for XCS constant prediction
 double XCSF_ETA; // learning rate for updating the computed prediction
@@ -61,6 +80,39 @@ _Bool ACTION_SUBSUMPTION; // whether to subsume more specific rules in action se
 _Bool GA_SUBSUMPTION; // whether to try and subsume offspring classifiers
 _Bool SET_SUBSUMPTION; // whether to perform match set subsumption
 double THETA_SUB; // minimum experience of a classifier to become a subsumer
+// matching parameters
+int MATCH_CACHE_SIZE; // number of input states with cached match sets (0 = off)
+_Bool MATCH_DELTA; // whether to match incrementally from the bits that changed
+int MATCH_INDEX; // 0 = linear scan, 1 = inverted bitset or spatial index, 2 = fastest of both, 3 = ternary trie
+// batch parameters
+int BATCH_SIZE; // single-step inputs explored together (1 = one at a time)
+// inference parameters
+int INFER_VERIFY; // random inputs to check a compiled population on (0 = off)
+int INFER_TABLE_BITS; // maximum input length tabulated by a compiled population
+// parallel parameters
+int NUM_THREADS; // number of threads used to match and build the prediction array
+int PAR_MATCH_MIN; // minimum population size for parallel matching
+int PAR_PA_MIN; // minimum match set size for a parallel prediction array
+// island parameters
+int ISLANDS; // number of populations learning in separate processes (0 = off)
+int MIGRATE_EVERY; // trials between migrations
+int MIGRATE_NUM; // classifiers sent to each neighbour per migration
+int MIGRATE_SELECT; // 0 = send the fittest, 1 = send the most experienced
+int MIGRATE_TOPOLOGY; // 0 = ring, 1 = fully connected
+int ISLAND_MERGE; // 0 = keep the best island's population, 1 = merge all
+int ISLAND_CONDENSE; // trials of condensation after merging
+double ISLAND_TARGET; // performance whose time to reach is reported
+// shared population parameters
+int HOGWILD; // number of threads training one population (0 = off)
+int HOGWILD_ROUND; // explore trials per thread between structural changes
+// serving parameters
+int SERVE_READERS; // maximum number of threads answering queries
+int SERVE_PUBLISH; // updates between publications of the population
+int SERVE_QUEUE; // maximum number of rewards waiting for the learner
+// sweep parameters
+char SWEEP[128]; // file of constants to sweep (none = off)
+int SWEEP_WORKERS; // processes running sweep jobs (0 = one per processor)
+int SWEEP_SAMPLES; // random configurations drawn (0 = the full grid)
 // set by environment
 _Bool multi_step; // whether the problem is single or multi-step
 double max_payoff; // maximum environment payoff for executing an action
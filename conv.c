@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The binary performance file converter.
+ *
+ * Prints the reports of binary performance files (written with PERF_BINARY)
+ * in the text format of the .dat files:
+ *
+ *   xcsconv dat/<time>-<exp>.bin [...]
+ *
+ * A file holds a header (magic, version, number of columns, and the name,
+ * type and printed decimals of each column) followed by blocks of rows, each
+ * a row count and then the values of every column in turn.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "perf.h"
+
+int conv_file(char *name);
+
+int main(int argc, char **argv)
+{
+	if(argc < 2) {
+		printf("Usage: xcsconv file.bin [...]\n");
+		exit(EXIT_FAILURE);
+	}
+	for(int i = 1; i < argc; i++) {
+		if(!conv_file(argv[i])) {
+			fprintf(stderr, "Invalid performance file: %s\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+int conv_file(char *name)
+{
+	FILE *f = fopen(name, "rb");
+	if(f == NULL)
+		return 0;
+	uint32_t head[3];
+	if(fread(head, sizeof(head), 1, f) != 1 || head[0] != PERF_BIN_MAGIC 
+			|| head[1] != 1 || head[2] < 1 || head[2] > 64) {
+		fclose(f);
+		return 0;
+	}
+	int cols = head[2];
+	char type[cols];
+	int decimals[cols];
+	for(int i = 0; i < cols; i++) {
+		char col[PERF_BIN_NAME+2];
+		if(fread(col, sizeof(col), 1, f) != 1) {
+			fclose(f);
+			return 0;
+		}
+		type[i] = col[PERF_BIN_NAME];
+		decimals[i] = col[PERF_BIN_NAME+1];
+	}
+	uint32_t rows;
+	int ok = 1;
+	while(ok && fread(&rows, sizeof(rows), 1, f) == 1) {
+		// read the block's columns, then print it a row at a time
+		char *block[cols];
+		for(int i = 0; i < cols; i++) {
+			size_t size = (type[i] == 'd') ? sizeof(double) : 4;
+			block[i] = malloc(size*rows);
+			if(fread(block[i], size, rows, f) != rows)
+				ok = 0;
+		}
+		for(uint32_t r = 0; ok && r < rows; r++) {
+			for(int i = 0; i < cols; i++) {
+				if(i > 0)
+					printf(" ");
+				if(type[i] == 'i') {
+					int32_t v;
+					memcpy(&v, block[i]+r*4, 4);
+					printf("%d", v);
+				}
+				else if(type[i] == 'd') {
+					double v;
+					memcpy(&v, block[i]+r*sizeof(double), sizeof(double));
+					printf("%.*f", decimals[i], v);
+				}
+				else {
+					float v;
+					memcpy(&v, block[i]+r*4, 4);
+					printf("%.*f", decimals[i], v);
+				}
+			}
+			printf("\n");
+		}
+		for(int i = 0; i < cols; i++)
+			free(block[i]);
+	}
+	fclose(f);
+	return ok;
+}
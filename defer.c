@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The deferred structural change module.
+ *
+ * Records, in order, the structural changes that trials would have made to
+ * the population, so that they can be made later from one thread: insertion
+ * of covering classifiers, and action set subsumption and the GA on action
+ * sets. The parameter updates of the trials are made immediately. Action set
+ * members removed before their request is applied are skipped, and removed
+ * classifiers must only be freed once all requests that may point at them
+ * have been applied. Covering classifiers are inserted as they are, and once
+ * every record of a round has been applied those that duplicate another of
+ * the round, e.g., when two threads covered the same state and action, are
+ * folded into it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "pstat.h"
+#include "ga.h"
+#include "defer.h"
+
+CL **df_cover; // covering classifiers inserted since the last fold
+int df_cover_num;
+int df_cover_cap;
+
+void defer_init(DEFER *d)
+{
+	memset(d, 0, sizeof(DEFER));
+}
+
+void defer_free(DEFER *d)
+{
+	free(d->req);
+	free(d->cl);
+	free(d->state);
+	free(df_cover);
+	df_cover = NULL;
+	df_cover_num = 0;
+	df_cover_cap = 0;
+}
+
+void defer_cover(DEFER *d, CL *c)
+{
+	// c is updated by its trial before being inserted
+	defer_set(d, NULL, 0, 0, NULL);
+	d->req[d->req_num-1].cover = c;
+}
+
+void defer_set(DEFER *d, CL **set, int size, int time, char *state)
+{
+	if(d->req_num == d->req_cap) {
+		d->req_cap = (d->req_cap == 0) ? 64 : d->req_cap * 2;
+		d->req = realloc(d->req, sizeof(DEFER_REQ)*d->req_cap);
+	}
+	DEFER_REQ *r = &d->req[d->req_num++];
+	r->cover = NULL;
+	r->time = time;
+	r->start = d->cl_num;
+	r->size = size;
+	r->state = d->state_num * state_length;
+	if(set == NULL)
+		return;
+	if(d->cl_num + size > d->cl_cap) {
+		d->cl_cap = 2 * (d->cl_num + size);
+		d->cl = realloc(d->cl, sizeof(CL*)*d->cl_cap);
+	}
+	memcpy(&d->cl[d->cl_num], set, sizeof(CL*)*size);
+	d->cl_num += size;
+	if(d->state_num == d->state_cap) {
+		d->state_cap = (d->state_cap == 0) ? 64 : d->state_cap * 2;
+		d->state = realloc(d->state, sizeof(char)*state_length*d->state_cap);
+	}
+	memcpy(&d->state[r->state], state, state_length);
+	d->state_num++;
+}
+
+int defer_apply(DEFER *d, NODE **kset)
+{
+	// makes the recorded changes, empties the record and returns the number
+	// of action set members that had been removed before their turn
+	int stale = 0;
+	for(int i = 0; i < d->req_num; i++) {
+		DEFER_REQ *r = &d->req[i];
+		if(r->cover != NULL) {
+			// kept separate from any duplicate as later requests may point
+			// at it
+			pop_insert(r->cover);
+			if(df_cover_num == df_cover_cap) {
+				df_cover_cap = (df_cover_cap == 0) ? 64 : df_cover_cap * 2;
+				df_cover = realloc(df_cover, sizeof(CL*)*df_cover_cap);
+			}
+			df_cover[df_cover_num++] = r->cover;
+			continue;
+		}
+		NODE *aset = NULL;
+		for(int j = 0; j < r->size; j++)
+			set_add(&aset, d->cl[r->start+j]);
+		int size, num;
+		set_validate(&aset, &size, &num);
+		stale += r->size - size;
+		if(ACTION_SUBSUMPTION)
+			set_subsumption(&aset, &size, &num, kset);
+		ga(&aset, size, num, r->time, &d->state[r->state], kset);
+		set_free(&aset);
+	}
+	d->req_num = 0;
+	d->cl_num = 0;
+	d->state_num = 0;
+	return stale;
+}
+
+void defer_fold(NODE **kset)
+{
+	// once all records have been applied, adds each covering classifier to
+	// a duplicate covered before it and enforces the population size; those
+	// folded join the kill set
+	_Bool folded = false;
+	for(int i = 0; i < df_cover_num; i++) {
+		CL *c = df_cover[i];
+		if(c->num == 0)
+			continue;
+		for(int j = i+1; j < df_cover_num; j++) {
+			CL *d = df_cover[j];
+			if(d->num > 0 && cl_duplicate(c, d)) {
+				c->num += d->num;
+				pstat_num(c, d->num);
+				pstat_num(d, -d->num);
+				d->num = 0;
+				pop_index_del(d);
+				set_add(kset, d);
+				folded = true;
+			}
+		}
+	}
+	if(folded)
+		set_validate(&pset, &pop_num, &pop_num_sum);
+	df_cover_num = 0;
+	pop_enforce_limit(kset);
+}
+
+void defer_update(CL **set, int size, double p, double *state)
+{
+	// the parameter updates of set_update for an action set held in an array
+	int num = 0;
+	for(int i = 0; i < size; i++)
+		num += set[i]->num;
+	double accs[size+1];
+	double acc_sum = 0.0;
+	for(int i = 0; i < size; i++) {
+		cl_update(set[i], state, p, num);
+		accs[i] = cl_acc(set[i]);
+		acc_sum += accs[i] * num;
+	}
+	for(int i = 0; i < size; i++)
+		cl_update_fit(set[i], acc_sum, accs[i]);
+}
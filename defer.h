@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+typedef struct DEFER_REQ {
+	CL *cover; // covering classifier to insert, or NULL for an action set
+	int start; // action set members in cl
+	int size;
+	int time;
+	int state; // offset of the state in state
+} DEFER_REQ;
+
+typedef struct DEFER {
+	DEFER_REQ *req;
+	int req_num;
+	int req_cap;
+	CL **cl; // action set members of the requests
+	int cl_num;
+	int cl_cap;
+	char *state; // states of the requests
+	int state_num;
+	int state_cap;
+} DEFER;
+
+int defer_apply(DEFER *d, NODE **kset);
+void defer_cover(DEFER *d, CL *c);
+void defer_fold(NODE **kset);
+void defer_free(DEFER *d);
+void defer_init(DEFER *d);
+void defer_set(DEFER *d, CL **set, int size, int time, char *state);
+void defer_update(CL **set, int size, double p, double *state);
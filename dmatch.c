@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The incremental (delta) matching module.
+ *
+ * Keeps the number of mismatching alleles of every classifier in the
+ * population against the last perceived state, along with an inverted list
+ * per bit of the classifiers specifying that bit. When the next state arrives
+ * only the classifiers in the lists of the flipped bits have their counts
+ * adjusted and the match set is updated with the classifiers whose count
+ * reaches or leaves zero. Consecutive states in the multi-step environments
+ * usually differ in only a few bits.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "dmatch.h"
+
+void dmatch_grow(int id);
+void dmatch_in(int id);
+void dmatch_out(int id);
+int dmatch_count(CL *c, char *state);
+
+char *dm_state; // last perceived state
+_Bool dm_valid; // whether dm_state has been set
+int dm_cap; // number of classifier slots allocated
+CL **dm_cl; // classifier in each slot
+int *dm_mis; // number of mismatching alleles in each slot
+int *dm_pos; // position of each slot in the match list, or -1
+int *dm_lpos; // position of each slot in the inverted list of each bit
+int **dm_list; // inverted list of slots specifying each bit
+int *dm_list_size;
+int *dm_list_cap;
+int *dm_match; // slots currently matching dm_state
+int dm_match_size;
+
+void dmatch_init()
+{
+	dm_state = malloc(sizeof(char)*state_length);
+	dm_valid = false;
+	dm_cap = 0;
+	dm_cl = NULL;
+	dm_mis = NULL;
+	dm_pos = NULL;
+	dm_lpos = NULL;
+	dm_match = NULL;
+	dm_match_size = 0;
+	dm_list = malloc(sizeof(int*)*state_length);
+	dm_list_size = malloc(sizeof(int)*state_length);
+	dm_list_cap = malloc(sizeof(int)*state_length);
+	for(int i = 0; i < state_length; i++) {
+		dm_list[i] = NULL;
+		dm_list_size[i] = 0;
+		dm_list_cap[i] = 0;
+	}
+}
+
+void dmatch_free()
+{
+	for(int i = 0; i < state_length; i++)
+		free(dm_list[i]);
+	free(dm_list);
+	free(dm_list_size);
+	free(dm_list_cap);
+	free(dm_state);
+	free(dm_cl);
+	free(dm_mis);
+	free(dm_pos);
+	free(dm_lpos);
+	free(dm_match);
+}
+
+void dmatch_grow(int id)
+{
+	// make room for slot id
+	if(id < dm_cap)
+		return;
+	int cap = dm_cap;
+	while(cap <= id)
+		cap = (cap == 0) ? 64 : cap * 2;
+	dm_cl = realloc(dm_cl, sizeof(CL*)*cap);
+	dm_mis = realloc(dm_mis, sizeof(int)*cap);
+	dm_pos = realloc(dm_pos, sizeof(int)*cap);
+	dm_lpos = realloc(dm_lpos, sizeof(int)*cap*state_length);
+	dm_match = realloc(dm_match, sizeof(int)*cap);
+	dm_cap = cap;
+}
+
+int dmatch_count(CL *c, char *state)
+{
+	int mis = 0;
+	for(int i = 0; i < state_length; i++) {
+		if(c->cond.string[i] != DONT_CARE && c->cond.string[i] != state[i])
+			mis++;
+	}
+	return mis;
+}
+
+void dmatch_in(int id)
+{
+	// slot enters the match list
+	dm_pos[id] = dm_match_size;
+	dm_match[dm_match_size] = id;
+	dm_match_size++;
+}
+
+void dmatch_out(int id)
+{
+	// slot leaves the match list; the last entry fills the gap
+	int pos = dm_pos[id];
+	dm_match_size--;
+	dm_match[pos] = dm_match[dm_match_size];
+	dm_pos[dm_match[pos]] = pos;
+	dm_pos[id] = -1;
+}
+
+void dmatch_add(CL *c)
+{
+	// a new macro-classifier has been added to the population
+	int id = c->id;
+	dmatch_grow(id);
+	dm_cl[id] = c;
+	dm_pos[id] = -1;
+	for(int i = 0; i < state_length; i++) {
+		if(c->cond.string[i] == DONT_CARE)
+			continue;
+		if(dm_list_size[i] == dm_list_cap[i]) {
+			dm_list_cap[i] = (dm_list_cap[i] == 0) ? 64 : dm_list_cap[i] * 2;
+			dm_list[i] = realloc(dm_list[i], sizeof(int)*dm_list_cap[i]);
+		}
+		dm_lpos[id*state_length+i] = dm_list_size[i];
+		dm_list[i][dm_list_size[i]] = id;
+		dm_list_size[i]++;
+	}
+	if(dm_valid) {
+		dm_mis[id] = dmatch_count(c, dm_state);
+		if(dm_mis[id] == 0)
+			dmatch_in(id);
+	}
+}
+
+void dmatch_del(CL *c)
+{
+	// a macro-classifier has been removed from the population
+	int id = c->id;
+	for(int i = 0; i < state_length; i++) {
+		if(c->cond.string[i] == DONT_CARE)
+			continue;
+		int pos = dm_lpos[id*state_length+i];
+		dm_list_size[i]--;
+		int last = dm_list[i][dm_list_size[i]];
+		dm_list[i][pos] = last;
+		dm_lpos[last*state_length+i] = pos;
+	}
+	if(dm_pos[id] >= 0)
+		dmatch_out(id);
+}
+
+void dmatch_get(NODE **mset, char *state)
+{
+	// builds the match set after propagating the bits changed since last time
+	if(!dm_valid) {
+		dm_match_size = 0;
+		for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+			int id = iter->cl->id;
+			dm_mis[id] = dmatch_count(iter->cl, state);
+			dm_pos[id] = -1;
+			if(dm_mis[id] == 0)
+				dmatch_in(id);
+		}
+		dm_valid = true;
+	}
+	else {
+		for(int i = 0; i < state_length; i++) {
+			if(state[i] == dm_state[i])
+				continue;
+			for(int j = 0; j < dm_list_size[i]; j++) {
+				int id = dm_list[i][j];
+				if(dm_cl[id]->cond.string[i] == state[i]) {
+					dm_mis[id]--;
+					if(dm_mis[id] == 0)
+						dmatch_in(id);
+				}
+				else {
+					dm_mis[id]++;
+					if(dm_mis[id] == 1)
+						dmatch_out(id);
+				}
+			}
+		}
+	}
+	memcpy(dm_state, state, sizeof(char)*state_length);
+	for(int i = 0; i < dm_match_size; i++)
+		set_add(mset, dm_cl[dm_match[i]]);
+	set_order(mset);
+}
@@ -71,6 +71,27 @@ void env_free()
 	}
 }
 
+_Bool env_thread_init()
+{
+	// gives the calling thread its own instance of the problem; false if
+	// the problem does not support it
+	switch(env) {
+		case MUX:
+			mux_thread_init();
+			return true;
+	}
+	return false;
+}
+
+void env_thread_free()
+{
+	switch(env) {
+		case MUX:
+			mux_thread_free();
+			break;
+	}
+}
+
 void env_reset()
 {
 	switch(env) {
@@ -123,3 +144,16 @@ _Bool env_is_reset()
 	}
 	exit(EXIT_FAILURE);
 }
+
+void env_conv_dstate(char *state, double *dstate)
+{
+	// real-valued input for an arbitrary binary state
+	switch(env) {
+		case MUX:
+			mux_conv_dstate(state, dstate);
+			break;
+		case MAZE:
+			maze_conv_dstate(state, dstate);
+			break;
+	}
+}
@@ -1,7 +1,10 @@
 void env_init(char **argv);
 void env_free();
+_Bool env_thread_init();
+void env_thread_free();
 double env_exec_action(int action);
 char *env_get_state();
 _Bool env_is_reset();
 void env_reset();
 double *env_get_dstate();
+void env_conv_dstate(char *state, double *dstate);
@@ -155,21 +155,26 @@ char *maze_state()
 }
 
 double *maze_dstate()
+{
+	maze_conv_dstate(state, dstate);
+	return dstate;
+}
+
+void maze_conv_dstate(char *s, double *d)
 {
 	double tmp;
 	// convert binary sensors to decimal
 	for(int i = 0; i < state_length; i+=encoding_bits) {
-		dstate[i/encoding_bits] = 0.0;
+		d[i/encoding_bits] = 0.0;
 		for(int j = 0; j < encoding_bits; j++) {
-			tmp = (double)(state[i+j] - '0');
+			tmp = (double)(s[i+j] - '0');
 			if(tmp > 0.0)
-				dstate[i/encoding_bits] += tmp+(tmp*pow(j,2));
+				d[i/encoding_bits] += tmp+(tmp*pow(j,2));
 		}
 	}
 	// scale between [-1,1]
 	for(int i = 0; i < dstate_length; i++)
-		dstate[i] = (dstate[i]/((pow(encoding_bits,2)-1.0)/2.0))-1.0;
-	return dstate;
+		d[i] = (d[i]/((pow(encoding_bits,2)-1.0)/2.0))-1.0;
 }
 
 void bin_sensor(char s, char *bin)
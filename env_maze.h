@@ -21,3 +21,4 @@ char *maze_state();
 double maze_execute(int move);
 _Bool maze_isreset();
 double *maze_dstate();
+void maze_conv_dstate(char *s, double *d);
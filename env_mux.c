@@ -37,60 +37,76 @@
 #define MAX_PAYOFF 1000.0
 
 int pos_bits;
-char *state;
-double *dstate;
+_Thread_local char *mux_st; // the current instance of each thread
+_Thread_local double *mux_dst;
 
 void mux_init(int bits)
 {
 	dstate_length = bits;
 	state_length = bits;
-	state = malloc(sizeof(char)*state_length);
 	num_actions = 2;
 	multi_step = false;
 	max_payoff = 1000.0;
-	dstate = malloc(sizeof(double)*dstate_length);
+	mux_thread_init();
 	for(pos_bits = 1.0; pos_bits+pow(2.0,pos_bits) <= state_length; pos_bits++);
 	pos_bits--;
 }
 
 void mux_free()
 {
-	free(state);
-	free(dstate);
+	mux_thread_free();
+}
+
+void mux_thread_init()
+{
+	// instance buffers for the calling thread
+	mux_st = malloc(sizeof(char)*state_length);
+	mux_dst = malloc(sizeof(double)*dstate_length);
+}
+
+void mux_thread_free()
+{
+	free(mux_st);
+	free(mux_dst);
 }
 
 char *mux_state()
 {
 	for (int i = 0; i < state_length; i++) {
 		if (drand() < 0.5)
-			state[i] = '0';
+			mux_st[i] = '0';
 		else
-			state[i] = '1';
+			mux_st[i] = '1';
 	}
-	return state;
+	return mux_st;
 }
 
 double *mux_dstate()
+{
+	mux_conv_dstate(mux_st, mux_dst);
+	return mux_dst;
+}
+
+void mux_conv_dstate(char *s, double *d)
 {
 	for(int i = 0; i < state_length; i++) {
-		if(state[i] == '0')
-			dstate[i] = -1.0;
+		if(s[i] == '0')
+			d[i] = -1.0;
 		else
-			dstate[i] = 1.0;
+			d[i] = 1.0;
 	}
-	return dstate;
 }
 
 double mux_execute(int act)
 {
 	int pos = pos_bits;
 	for (int i = 0; i < pos_bits; i++) {
-		if (state[i] == '1')
+		if (mux_st[i] == '1')
 			pos += pow(2.0, (double)(pos_bits-1-i));
 	}
 	int answer;
 	for(int i = 31; i >= 0; i--) {
-		if((state[pos] & (1 << i)) != 0)
+		if((mux_st[pos] & (1 << i)) != 0)
 			answer = 1;
 		else
 			answer = 0;
@@ -16,6 +16,9 @@
  */
 void mux_init(int bits);
 void mux_free();
+void mux_thread_free();
+void mux_thread_init();
 double mux_execute(int act);
 char *mux_state();
 double *mux_dstate();
+void mux_conv_dstate(char *s, double *d);
@@ -39,20 +39,28 @@ void exploit_multi(int *perf, double *err, int trial, int step);
 
 void multi_step_exp(int *perf, double *err)
 {
-	pa_init();
-	int expl = 0;
-	int expl_step = 0;
-	for(int expl_trial = 0; expl_trial < MAX_TRIALS; expl_trial += expl) {
-		expl = (expl+1)%2;
+	multi_step_run(0, MAX_TRIALS, 0, perf, err);
+}
+
+int multi_step_run(int from, int to, int step, int *perf, double *err)
+{
+	// explore trials [from,to), each followed by an exploit trial; step is
+	// the number of explore steps taken so far and the new count is returned
+	int expl_step = step;
+	for(int t = from; t < to; t++) {
+		env_reset();
+		expl_step = explore_multi(expl_step);
+		// the exploit trial and report also end a range, so that ranges run
+		// in turn (the islands') give what one run gives, which ends with
+		// its last explore trial
+		if(t+1 == MAX_TRIALS)
+			break;
 		env_reset();
-		if(expl == 1)
-			expl_step = explore_multi(expl_step);
-		else
-			exploit_multi(perf, err, expl_trial, expl_step);
-		if(expl_trial%PERF_AVG_TRIALS == 0 && expl == 0 && expl_trial > 0)
-			disp_perf(perf, err, expl_trial);
+		exploit_multi(perf, err, t+1, expl_step);
+		if((t+1)%PERF_AVG_TRIALS == 0)
+			disp_perf(perf, err, t+1);
 	}
-	pa_free();
+	return expl_step;
 }
 
 int explore_multi(int step)
@@ -70,13 +78,13 @@ int explore_multi(int step)
 		double *dstate = env_get_dstate();
 		// generate match set
 		NODE *mset = NULL;
-		set_match(&mset, state, step+steps, &kset);
+		set_match(&mset, state, dstate, step+steps, &kset);
 		// select a random move
 		pa_build(&mset, dstate);
 		int action = pa_rand_action();
 		// generate action set
 		NODE *aset = NULL; int anum = 0;
-		int asize = set_action(&mset, &aset, action, &anum);
+		int asize = pa_set_action(&aset, action, &anum);
 		// get environment feedback
 		double reward = env_exec_action(action);
 		reset = env_is_reset();
@@ -122,14 +130,14 @@ void exploit_multi(int *perf, double *err, int trial, int step)
 		double *dstate = env_get_dstate();
 		// generate match set
 		NODE *mset = NULL;
-		set_match(&mset, state, step, &kset);
+		set_match(&mset, state, dstate, step, &kset);
 		// select the best move
 		pa_build(&mset, dstate);
 		int action = pa_best_action();
 		// generate action set
 		int anum = 0;
 		NODE *aset = NULL;
-		int asize = set_action(&mset, &aset, action, &anum);
+		int asize = pa_set_action(&aset, action, &anum);
 		// get environment feedback
 		double reward = env_exec_action(action);
 		reset = env_is_reset();
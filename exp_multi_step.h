@@ -15,4 +15,5 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+int multi_step_run(int from, int to, int step, int *perf, double *err);
 void multi_step_exp(int *perf, double *err);
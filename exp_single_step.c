@@ -18,6 +18,13 @@
  * Description: 
  **************
  * The single-step experiment module.
+ *
+ * Explore trials draw an instance and the reward of every action and train
+ * the learner through the library interface, xcs_train_batch, one instance
+ * at a time or BATCH_SIZE together. Exploit trials are the one place the
+ * experiment reaches past the interface: they match with set_match, so that
+ * as in the original algorithm an exploit trial covers missing actions,
+ * whereas xcs_predict_batch leaves the population unchanged.
  */
 
 #include <stdio.h>
@@ -29,58 +36,81 @@
 #include "cl.h"
 #include "cl_set.h"
 #include "pa.h"
-#include "ga.h"
 #include "env.h"
 #include "perf.h"
+#include "xcs.h"
 #include "exp_single_step.h"
  
-void explore_single(int time);
+void explore(XCS *x, int n);
+void single_step_batch(XCS *x, int from, int to, int *perf, double *err);
 void exploit_single(int time, int *correct, double *error);
 
-void single_step_exp(int *perf, double *err)
+void single_step_exp(XCS *x, int *perf, double *err)
+{
+	single_step_run(x, 0, MAX_TRIALS, perf, err);
+}
+
+void single_step_run(XCS *x, int from, int to, int *perf, double *err)
 {
-	pa_init();
-	int expl = 0;
-	for(int expl_p = 0; expl_p < MAX_TRIALS; expl_p += expl) {
-		expl = (expl+1)%2;
-		if(expl == 1)
-			explore_single(expl_p);
-		else
-			exploit_single(expl_p, perf, err);
-		if(expl_p%PERF_AVG_TRIALS == 0 && expl == 0 && expl_p > 0)
-			disp_perf(perf, err, expl_p);
+	// explore trials [from,to), each followed by an exploit trial; the
+	// learner's time is the number of explore trials
+	if(BATCH_SIZE > 1) {
+		single_step_batch(x, from, to, perf, err);
+		return;
+	}
+	for(int t = from; t < to; t++) {
+		explore(x, 1);
+		// the exploit trial and report also end a range, so that ranges run
+		// in turn (the islands') give what one run gives, which ends with
+		// its last explore trial
+		if(t+1 == MAX_TRIALS)
+			break;
+		exploit_single(t+1, perf, err);
+		if((t+1)%PERF_AVG_TRIALS == 0)
+			disp_perf(perf, err, t+1);
 	}
-	pa_free();
 }
  
-void explore_single(int time)
+void single_step_batch(XCS *x, int from, int to, int *perf, double *err)
 {
-	char *state = env_get_state();
-	NODE *mset = NULL, *kset = NULL;
-	set_match(&mset, state, time, &kset);
-	double *dstate = env_get_dstate();
-	pa_build(&mset, dstate);
-	int action = pa_rand_action();
-	NODE *aset = NULL; int anum = 0;
-	int asize = set_action(&mset, &aset, action, &anum);
-	double reward = env_exec_action(action);
-	set_update(&aset, &asize, &anum, 0.0, reward, &kset, dstate);
-	ga(&aset, asize, anum, time, state, &kset);
-	set_free(&aset);
-	set_free(&mset);
-	set_kill(&kset);
+	// batches of explore trials, then as many exploit trials
+	for(int t = from; t < to; t += BATCH_SIZE) {
+		int n = (to - t < BATCH_SIZE) ? to - t : BATCH_SIZE;
+		explore(x, n);
+		for(int i = t; i < t+n; i++) {
+			exploit_single(i, perf, err);
+			if(i%PERF_AVG_TRIALS == 0 && i > 0)
+				disp_perf(perf, err, i);
+		}
+	}
+}
+
+void explore(XCS *x, int n)
+{
+	// the reward of every action is noted when each instance is drawn
+	char states[state_length*n];
+	double dstates[dstate_length*n];
+	double rewards[num_actions*n];
+	for(int i = 0; i < n; i++) {
+		memcpy(&states[i*state_length], env_get_state(), state_length);
+		memcpy(&dstates[i*dstate_length], env_get_dstate(), 
+				sizeof(double)*dstate_length);
+		for(int a = 0; a < num_actions; a++)
+			rewards[i*num_actions+a] = env_exec_action(a);
+	}
+	xcs_train_batch(x, states, dstates, rewards, n);
 }
 
 void exploit_single(int time, int *correct, double *error)
 {
 	char *state = env_get_state();
-	NODE *mset = NULL, *kset = NULL;
-	set_match(&mset, state, time, &kset);
 	double *dstate = env_get_dstate();
+	NODE *mset = NULL, *kset = NULL;
+	set_match(&mset, state, dstate, time, &kset);
 	pa_build(&mset, dstate);
 	int action = pa_best_action();
 	NODE *aset = NULL; int anum = 0;
-	set_action(&mset, &aset, action, &anum);
+	pa_set_action(&aset, action, &anum);
 	double reward = env_exec_action(action);
 	if(reward > 0)
 		correct[time%PERF_AVG_TRIALS] = 1;
@@ -15,4 +15,5 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-void single_step_exp(int *perf, double *err);
+void single_step_exp(XCS *x, int *perf, double *err);
+void single_step_run(XCS *x, int from, int to, int *perf, double *err);
@@ -22,7 +22,8 @@
  * Selects parents to create offspring via crossover and mutation, and inserts
  * the newly created classifiers into the population. The maximum population
  * size limit is then enforced by deleting excess classifiers from the
- * population. Performs GA subsumption if enabled.
+ * population. Performs GA subsumption if enabled. Crossover, mutation and
+ * GA subsumption may instead run on a separate thread; see ga_async.c.
  */
 
 #include <stdio.h>
@@ -34,17 +35,20 @@
 #include "cl.h"
 #include "cl_set.h"    
 #include "ga.h"
+#include "ga_async.h"
+#include "pstat.h"
 
-void ga_crossover(CL *c1, CL *c2);
-_Bool ga_mutate(CL *c, char *state);
 CL *ga_select_parent(NODE **set, double fit_sum);
 void ga_subsume(CL *c, CL *c1p, CL *c2p, NODE **set, int size);
 
 void ga(NODE **set, int size, int num, int time, char *state, NODE **kset)
 {
 	// check if the genetic algorithm should be run
-	if(size == 0 || time - set_mean_time(set, num) < THETA_GA)
+	if(size == 0 || time - set_mean_time(set, num) < THETA_GA) {
+		if(GA_QUEUE > 0)
+			ga_async_apply(time, kset);
 		return;
+	}
 	set_times(set, time);
 	// select parents
 	double fit_sum = set_total_fit(set);
@@ -62,6 +66,12 @@ void ga(NODE **set, int size, int num, int time, char *state, NODE **kset)
 	c2->fit = c2p->fit / c2p->num;
 	c1->fit = FIT_REDUC * (c1->fit + c2->fit)/2.0;
 	c2->fit = c1->fit;
+	// or have them applied by the GA thread, if it could be started
+	if(GA_QUEUE > 0 
+			&& ga_async_push(set, c1, c2, c1p, c2p, time, state, kset)) {
+		ga_async_apply(time, kset);
+		return;
+	}
 	// apply genetic operators to offspring
 	ga_crossover(c1, c2);
 	ga_mutate(c1, state);
@@ -84,11 +94,13 @@ void ga_subsume(CL *c, CL *c1p, CL *c2p, NODE **set, int size)
 	if(cl_subsumes(c1p, c)) {
 		c1p->num++;
 		pop_num_sum++;
+		pstat_num(c1p, 1);
 		cl_free(c);
 	}
 	else if(cl_subsumes(c2p, c)) {
 		c2p->num++;
 		pop_num_sum++;
+		pstat_num(c2p, 1);
 		cl_free(c);
 	}
 	// attempt to find a random subsumer from the set
@@ -103,8 +115,10 @@ void ga_subsume(CL *c, CL *c1p, CL *c2p, NODE **set, int size)
 		}
 		// found
 		if(choices > 0) {
-			candidates[irand(0,choices)]->cl->num++;
+			CL *s = candidates[irand(0,choices)]->cl;
+			s->num++;
 			pop_num_sum++;
+			pstat_num(s, 1);
 			cl_free(c);
 		}
 		// if no subsumers are found the offspring is added to the population
@@ -16,3 +16,5 @@
  */
 
 void ga(NODE **set, int size, int num, int time, char *state, NODE **kset);
+void ga_crossover(CL *c1, CL *c2);
+_Bool ga_mutate(CL *c, char *state);
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The asynchronous genetic algorithm module.
+ *
+ * When GA_QUEUE > 0 the GA selects and copies the parents on the main thread
+ * and pushes a snapshot to a worker thread: the offspring, the trial's state,
+ * and the condition, action, experience and error of each action set member
+ * able to subsume. The worker applies crossover and mutation and searches
+ * the snapshot for subsumers. Finished jobs are applied in order by the main
+ * thread the next time the GA is invoked, which is the point of the trial
+ * where the synchronous GA makes its changes. A subsumer that has left the
+ * population, or no longer subsumes the offspring, is replaced by inserting
+ * the offspring.
+ *
+ * At most GA_QUEUE jobs are outstanding and a job is applied at most GA_STALE
+ * time steps after its snapshot (0 = no bound); the main thread waits for the
+ * worker when either bound is reached. If the worker cannot be started the
+ * GA runs synchronously instead. The jobs, waits, mean lag, lost subsumers
+ * and synchronous runs are reported by ga_async_stats.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <pthread.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "ga.h"
+#include "ga_async.h"
+#include "pstat.h"
+
+typedef struct GA_JOB {
+	CL *off[2]; // offspring
+	int parent[2]; // candidate index of each parent, or -1
+	int subsumer[2]; // candidate subsuming each offspring, or -1
+	CL **cand; // members able to subsume at the snapshot
+	int *cand_id; // their population slots
+	CL *copy; // condition, action, experience and error of each candidate
+	int cand_num;
+	int cand_cap;
+	char *state;
+	int time;
+} GA_JOB;
+
+void ga_async_breed(GA_JOB *j);
+void ga_async_insert(GA_JOB *j, int time, NODE **kset);
+_Bool ga_async_ready(_Bool wait);
+int ga_async_subsumer(GA_JOB *j, CL *c);
+void *ga_async_worker(void *arg);
+
+GA_JOB *gw_jobs; // ring of GA_QUEUE jobs
+long gw_pushed; // jobs pushed, bred by the worker, and applied
+long gw_bred;
+long gw_applied;
+_Bool gw_started;
+_Bool gw_failed; // the worker could not be started
+_Bool gw_quit;
+pthread_t gw_thread;
+pthread_mutex_t gw_lock;
+pthread_cond_t gw_work;
+pthread_cond_t gw_done;
+unsigned long gw_seed;
+long gw_waits;
+long gw_lag;
+long gw_lost;
+long gw_sync; // GA runs made synchronously for want of the worker
+
+void ga_async_init()
+{
+	gw_jobs = calloc(GA_QUEUE, sizeof(GA_JOB));
+	for(int i = 0; i < GA_QUEUE; i++)
+		gw_jobs[i].state = malloc(sizeof(char)*state_length);
+	gw_pushed = 0;
+	gw_bred = 0;
+	gw_applied = 0;
+	gw_started = false;
+	gw_failed = false;
+	gw_quit = false;
+	gw_waits = 0;
+	gw_lag = 0;
+	gw_lost = 0;
+	gw_sync = 0;
+	pthread_mutex_init(&gw_lock, NULL);
+	pthread_cond_init(&gw_work, NULL);
+	pthread_cond_init(&gw_done, NULL);
+}
+
+void ga_async_free()
+{
+	if(gw_started) {
+		pthread_mutex_lock(&gw_lock);
+		gw_quit = true;
+		pthread_cond_signal(&gw_work);
+		pthread_mutex_unlock(&gw_lock);
+		pthread_join(gw_thread, NULL);
+	}
+	// offspring not yet applied are discarded
+	for(long i = gw_applied; i < gw_pushed; i++) {
+		GA_JOB *j = &gw_jobs[i % GA_QUEUE];
+		cl_free(j->off[0]);
+		cl_free(j->off[1]);
+	}
+	for(int i = 0; i < GA_QUEUE; i++) {
+		GA_JOB *j = &gw_jobs[i];
+		for(int k = 0; k < j->cand_cap; k++) {
+			cond_free(&j->copy[k].cond);
+			act_free(&j->copy[k].act);
+		}
+		free(j->cand);
+		free(j->cand_id);
+		free(j->copy);
+		free(j->state);
+	}
+	free(gw_jobs);
+	pthread_mutex_destroy(&gw_lock);
+	pthread_cond_destroy(&gw_work);
+	pthread_cond_destroy(&gw_done);
+}
+
+void ga_async_stats(long *jobs, long *waits, double *lag, long *lost, 
+		long *sync)
+{
+	*jobs = gw_applied;
+	*waits = gw_waits;
+	*lag = (gw_applied > 0) ? (double)gw_lag / gw_applied : 0.0;
+	*lost = gw_lost;
+	*sync = gw_sync;
+}
+
+_Bool ga_async_push(NODE **set, CL *c1, CL *c2, CL *c1p, CL *c2p, int time, 
+		char *state, NODE **kset)
+{
+	// the worker is started on first use, in the process that trains; if
+	// it cannot be, false is returned and the caller runs the GA itself
+	if(!gw_started) {
+		if(!gw_failed) {
+			gw_seed = irand(1, INT_MAX);
+			if(pthread_create(&gw_thread, NULL, ga_async_worker, NULL) == 0)
+				gw_started = true;
+			else
+				gw_failed = true;
+		}
+		if(!gw_started) {
+			gw_sync++;
+			return false;
+		}
+	}
+	// a full queue waits for its oldest job
+	if(gw_pushed - gw_applied == GA_QUEUE) {
+		ga_async_ready(true);
+		ga_async_insert(&gw_jobs[gw_applied % GA_QUEUE], time, kset);
+	}
+	// snapshot; the worker only touches jobs pushed but not yet bred
+	GA_JOB *j = &gw_jobs[gw_pushed % GA_QUEUE];
+	j->off[0] = c1;
+	j->off[1] = c2;
+	j->parent[0] = -1;
+	j->parent[1] = -1;
+	j->cand_num = 0;
+	for(NODE *iter = *set; iter != NULL && GA_SUBSUMPTION; iter = iter->next) {
+		CL *c = iter->cl;
+		if(!cl_subsumer(c))
+			continue;
+		if(j->cand_num == j->cand_cap) {
+			int cap = (j->cand_cap == 0) ? 16 : j->cand_cap * 2;
+			j->cand = realloc(j->cand, sizeof(CL*)*cap);
+			j->cand_id = realloc(j->cand_id, sizeof(int)*cap);
+			j->copy = realloc(j->copy, sizeof(CL)*cap);
+			for(int k = j->cand_cap; k < cap; k++) {
+				cond_init(&j->copy[k].cond);
+				act_init(&j->copy[k].act);
+			}
+			j->cand_cap = cap;
+		}
+		int k = j->cand_num++;
+		j->cand[k] = c;
+		j->cand_id[k] = c->id;
+		cond_copy(&j->copy[k].cond, &c->cond);
+		act_copy(&j->copy[k].act, &c->act);
+		j->copy[k].exp = c->exp;
+		j->copy[k].err = c->err;
+		if(c == c1p)
+			j->parent[0] = k;
+		if(c == c2p)
+			j->parent[1] = k;
+	}
+	memcpy(j->state, state, sizeof(char)*state_length);
+	j->time = time;
+	pthread_mutex_lock(&gw_lock);
+	gw_pushed++;
+	pthread_cond_signal(&gw_work);
+	pthread_mutex_unlock(&gw_lock);
+	return true;
+}
+
+void ga_async_apply(int time, NODE **kset)
+{
+	// inserts the offspring of finished jobs, oldest first, waiting for any
+	// job that has reached the staleness bound
+	while(gw_applied < gw_pushed) {
+		GA_JOB *j = &gw_jobs[gw_applied % GA_QUEUE];
+		_Bool stale = GA_STALE > 0 && time - j->time >= GA_STALE;
+		if(!ga_async_ready(stale))
+			break;
+		ga_async_insert(j, time, kset);
+	}
+}
+
+_Bool ga_async_ready(_Bool wait)
+{
+	// whether the oldest job has been bred, optionally waiting until it is
+	pthread_mutex_lock(&gw_lock);
+	if(wait && gw_bred == gw_applied) {
+		gw_waits++;
+		while(gw_bred == gw_applied)
+			pthread_cond_wait(&gw_done, &gw_lock);
+	}
+	_Bool ready = gw_bred > gw_applied;
+	pthread_mutex_unlock(&gw_lock);
+	return ready;
+}
+
+void ga_async_insert(GA_JOB *j, int time, NODE **kset)
+{
+	for(int k = 0; k < 2; k++) {
+		CL *c = j->off[k];
+		int s = j->subsumer[k];
+		if(s >= 0 && pop_live(j->cand[s], j->cand_id[s]) 
+				&& cl_subsumes(j->cand[s], c)) {
+			j->cand[s]->num++;
+			pop_num_sum++;
+			pstat_num(j->cand[s], 1);
+			cl_free(c);
+		}
+		else {
+			if(s >= 0)
+				gw_lost++;
+			pop_add(c);
+		}
+	}
+	pop_enforce_limit(kset);
+	gw_lag += time - j->time;
+	gw_applied++;
+}
+
+void *ga_async_worker(void *arg)
+{
+	(void)arg;
+	random_seed(gw_seed);
+	pthread_mutex_lock(&gw_lock);
+	while(true) {
+		while(gw_bred == gw_pushed && !gw_quit)
+			pthread_cond_wait(&gw_work, &gw_lock);
+		if(gw_quit)
+			break;
+		GA_JOB *j = &gw_jobs[gw_bred % GA_QUEUE];
+		pthread_mutex_unlock(&gw_lock);
+		ga_async_breed(j);
+		pthread_mutex_lock(&gw_lock);
+		gw_bred++;
+		pthread_cond_signal(&gw_done);
+	}
+	pthread_mutex_unlock(&gw_lock);
+	return NULL;
+}
+
+void ga_async_breed(GA_JOB *j)
+{
+	ga_crossover(j->off[0], j->off[1]);
+	ga_mutate(j->off[0], j->state);
+	ga_mutate(j->off[1], j->state);
+	for(int k = 0; k < 2; k++)
+		j->subsumer[k] = GA_SUBSUMPTION ? ga_async_subsumer(j, j->off[k]) : -1;
+}
+
+int ga_async_subsumer(GA_JOB *j, CL *c)
+{
+	// as ga_subsume: either parent, otherwise a random member of the snapshot
+	for(int k = 0; k < 2; k++) {
+		int p = j->parent[k];
+		if(p >= 0 && cl_subsumes(&j->copy[p], c))
+			return p;
+	}
+	if(j->cand_num == 0)
+		return -1;
+	int candidates[j->cand_num];
+	int choices = 0;
+	for(int k = 0; k < j->cand_num; k++) {
+		if(cl_subsumes(&j->copy[k], c))
+			candidates[choices++] = k;
+	}
+	if(choices > 0)
+		return candidates[irand(0, choices)];
+	return -1;
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+_Bool ga_async_push(NODE **set, CL *c1, CL *c2, CL *c1p, CL *c2p, int time, 
+		char *state, NODE **kset);
+void ga_async_apply(int time, NODE **kset);
+void ga_async_free();
+void ga_async_init();
+void ga_async_stats(long *jobs, long *waits, double *lag, long *lost, 
+		long *sync);
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The shared population (Hogwild) module.
+ *
+ * HOGWILD worker threads each step their own instance of a single-step
+ * problem against one population. Trials proceed in rounds of HOGWILD_ROUND
+ * explore trials per worker, each followed by an exploit trial, during which
+ * the population's membership is frozen: workers match by scanning it without
+ * locks and update the parameters of the classifiers in their action sets in
+ * place, without synchronisation, so concurrent updates to one classifier may
+ * be lost. Structural changes are instead queued by each worker in order:
+ * covering classifiers (created by the worker and used in its own trial) and
+ * the action sets on which subsumption and the GA are to be attempted. At the
+ * end of each round the main thread applies the queues one after the other,
+ * enforcing the population size limit as it goes, while the workers wait.
+ * Exploit trials do not cover.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "env.h"
+#include "perf.h"
+#include "defer.h"
+#include "hogwild.h"
+
+typedef struct WORKER {
+	pthread_t thread;
+	unsigned long seed;
+	int id;
+	CL **mset; // match set
+	int mset_cap;
+	DEFER queue; // structural changes
+	int *perf; // most recent exploit results
+	double *err;
+	long exploits;
+	long covered;
+} WORKER;
+
+double hogwild_time();
+void *hogwild_worker(void *arg);
+void hogwild_explore(WORKER *w, int time);
+void hogwild_exploit(WORKER *w);
+int hogwild_match(WORKER *w, char *state, double *dstate, double *pa, int time);
+
+WORKER *hw_workers;
+pthread_barrier_t hw_start;
+pthread_barrier_t hw_end;
+_Bool hw_done;
+int hw_time; // explore trials completed before the current round
+int hw_round; // explore trials per worker in the current round
+
+void hogwild_exp(int *perf, double *err)
+{
+	if(multi_step) {
+		printf("Error: shared population training needs a single-step problem\n");
+		exit(EXIT_FAILURE);
+	}
+	// start the workers
+	unsigned long seed = irand(1, INT_MAX);
+	hw_workers = malloc(sizeof(WORKER)*HOGWILD);
+	pthread_barrier_init(&hw_start, NULL, HOGWILD+1);
+	pthread_barrier_init(&hw_end, NULL, HOGWILD+1);
+	hw_done = false;
+	hw_time = 0;
+	for(int i = 0; i < HOGWILD; i++) {
+		WORKER *w = &hw_workers[i];
+		memset(w, 0, sizeof(WORKER));
+		w->id = i;
+		w->seed = seed + i;
+		w->perf = calloc(PERF_AVG_TRIALS, sizeof(int));
+		w->err = calloc(PERF_AVG_TRIALS, sizeof(double));
+		defer_init(&w->queue);
+		if(pthread_create(&w->thread, NULL, hogwild_worker, w) != 0) {
+			printf("Error creating worker %d\n", i);
+			exit(EXIT_FAILURE);
+		}
+	}
+	// run rounds
+	double start = hogwild_time();
+	double applying = 0.0;
+	long requests = 0;
+	while(hw_time < MAX_TRIALS) {
+		int left = (MAX_TRIALS - hw_time + HOGWILD - 1) / HOGWILD;
+		hw_round = (HOGWILD_ROUND > 0) ? HOGWILD_ROUND : 1;
+		if(left < hw_round)
+			hw_round = left;
+		pthread_barrier_wait(&hw_start);
+		pthread_barrier_wait(&hw_end);
+		double t = hogwild_time();
+		NODE *kset = NULL;
+		for(int i = 0; i < HOGWILD; i++) {
+			requests += hw_workers[i].queue.req_num;
+			defer_apply(&hw_workers[i].queue, &kset);
+		}
+		defer_fold(&kset);
+		set_kill(&kset);
+		applying += hogwild_time() - t;
+		int prev = hw_time;
+		hw_time += hw_round * HOGWILD;
+		if(hw_time / PERF_AVG_TRIALS > prev / PERF_AVG_TRIALS) {
+			// the latest results of each worker in turn
+			for(int i = 0; i < PERF_AVG_TRIALS; i++) {
+				WORKER *w = &hw_workers[i % HOGWILD];
+				int j = (w->exploits - 1 - i / HOGWILD) % PERF_AVG_TRIALS;
+				if(j < 0)
+					j += PERF_AVG_TRIALS;
+				perf[i] = w->perf[j];
+				err[i] = w->err[j];
+			}
+			disp_perf(perf, err, hw_time / PERF_AVG_TRIALS * PERF_AVG_TRIALS);
+		}
+	}
+	double secs = hogwild_time() - start;
+	// stop the workers
+	hw_done = true;
+	pthread_barrier_wait(&hw_start);
+	long covered = 0;
+	for(int i = 0; i < HOGWILD; i++) {
+		WORKER *w = &hw_workers[i];
+		pthread_join(w->thread, NULL);
+		covered += w->covered;
+		free(w->mset);
+		defer_free(&w->queue);
+		free(w->perf);
+		free(w->err);
+	}
+	free(hw_workers);
+	pthread_barrier_destroy(&hw_start);
+	pthread_barrier_destroy(&hw_end);
+	perf_drain();
+	printf("hogwild: %d workers, %d trials in %.3fs (%.0f/s), %ld queued changes "
+			"(%ld covering), %.1f%% of the time applying them\n", HOGWILD, 
+			hw_time, secs, hw_time / secs, requests, covered, 
+			100.0 * applying / secs);
+}
+
+void *hogwild_worker(void *arg)
+{
+	WORKER *w = arg;
+	random_seed(w->seed);
+	env_thread_init();
+	while(true) {
+		pthread_barrier_wait(&hw_start);
+		if(hw_done)
+			break;
+		for(int i = 0; i < hw_round; i++) {
+			hogwild_explore(w, hw_time + i * HOGWILD + w->id);
+			hogwild_exploit(w);
+		}
+		pthread_barrier_wait(&hw_end);
+	}
+	env_thread_free();
+	return NULL;
+}
+
+int hogwild_match(WORKER *w, char *state, double *dstate, double *pa, int time)
+{
+	// match set and prediction array; with a time, actions not advocated
+	// are covered by new classifiers queued for insertion
+	int n = 0, m_num = 0;
+	double nr[num_actions];
+	_Bool covered[num_actions];
+	for(int i = 0; i < num_actions; i++) {
+		pa[i] = 0.0;
+		nr[i] = 0.0;
+		covered[i] = false;
+	}
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		// workers matching one classifier at once only race on its match
+		// flag, which nothing reads
+		CL *c = iter->cl;
+		if(!cond_match(&c->cond, state, dstate))
+			continue;
+		if(n == w->mset_cap) {
+			w->mset_cap = (w->mset_cap == 0) ? 64 : w->mset_cap * 2;
+			w->mset = realloc(w->mset, sizeof(CL*)*w->mset_cap);
+		}
+		w->mset[n++] = c;
+		covered[c->act.a] = true;
+		m_num += c->num;
+	}
+	for(int i = 0; time >= 0 && i < num_actions; i++) {
+		if(covered[i])
+			continue;
+		CL *c = malloc(sizeof(CL));
+		cl_init(c, m_num+1, time);
+		cl_cover(c, state, dstate, i);
+		if(n == w->mset_cap) {
+			w->mset_cap = (w->mset_cap == 0) ? 64 : w->mset_cap * 2;
+			w->mset = realloc(w->mset, sizeof(CL*)*w->mset_cap);
+		}
+		w->mset[n++] = c;
+		m_num++;
+		defer_cover(&w->queue, c);
+		w->covered++;
+	}
+	for(int i = 0; i < n; i++) {
+		CL *c = w->mset[i];
+		pa[c->act.a] += pred_compute(&c->pred, dstate) * c->fit;
+		nr[c->act.a] += c->fit;
+	}
+	for(int i = 0; i < num_actions; i++)
+		pa[i] = (nr[i] != 0.0) ? pa[i] / nr[i] : 0.0;
+	return n;
+}
+
+void hogwild_explore(WORKER *w, int time)
+{
+	char *state = env_get_state();
+	double *dstate = env_get_dstate();
+	double pa[num_actions];
+	int n = hogwild_match(w, state, dstate, pa, time);
+	// action set of a random action
+	int action = irand(0, num_actions);
+	CL *aset[n+1];
+	int size = 0, num = 0;
+	for(int i = 0; i < n; i++) {
+		if(w->mset[i]->act.a == action) {
+			aset[size++] = w->mset[i];
+			num += w->mset[i]->num;
+		}
+	}
+	double reward = env_exec_action(action);
+	defer_update(aset, size, reward, dstate);
+	// subsumption and the GA are applied at the end of the round
+	double time_sum = 0.0;
+	for(int i = 0; i < size; i++)
+		time_sum += aset[i]->time * aset[i]->num;
+	if(ACTION_SUBSUMPTION || (size > 0 && time - time_sum / num >= THETA_GA))
+		defer_set(&w->queue, aset, size, time, state);
+}
+
+void hogwild_exploit(WORKER *w)
+{
+	char *state = env_get_state();
+	double *dstate = env_get_dstate();
+	double pa[num_actions];
+	int n = hogwild_match(w, state, dstate, pa, -1);
+	// as pa_best_action, the lowest numbered of the best advocated actions,
+	// or 0 for an empty match set
+	int action = -1;
+	for(int i = 0; i < n; i++) {
+		int a = w->mset[i]->act.a;
+		if(action < 0 || pa[action] < pa[a] 
+				|| (pa[action] == pa[a] && a < action))
+			action = a;
+	}
+	if(action < 0)
+		action = 0;
+	double reward = env_exec_action(action);
+	int k = w->exploits % PERF_AVG_TRIALS;
+	w->perf[k] = (reward > 0) ? 1 : 0;
+	w->err[k] = fabs(reward - pa[action]);
+	w->exploits++;
+}
+
+double hogwild_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
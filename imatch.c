@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The interval condition matching module.
+ *
+ * Mirrors the bounds of the population's interval conditions in a structure
+ * of arrays: population slots are grouped in blocks of IMATCH_LANES and each
+ * block holds, for every input, the lower bounds of its slots followed by
+ * their upper bounds. A block is matched one input at a time with vector
+ * compares whose results are ANDed into a lane mask, stopping as soon as no
+ * lane is left. Free slots hold empty intervals so they never match. The
+ * vector block match is compiled for AVX2 and used when the kernel module
+ * selected an AVX2 or wider variant.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "kern.h"
+#include "imatch.h"
+#ifdef KERN_X86
+#include <immintrin.h>
+#endif
+
+#define IMATCH_LANES 8 // slots per block, one AVX register of floats
+
+void imatch_grow(int id);
+int imatch_block(const float *f, const float *x);
+#ifdef KERN_X86
+int imatch_block_avx2(const float *f, const float *x);
+#endif
+
+int (*im_block)(const float *f, const float *x); // lane mask of one block
+CL **im_cl; // classifier in each slot
+float *im_bounds; // per block and input: IMATCH_LANES lower then upper bounds
+int im_blocks; // blocks allocated
+int im_top; // one past the highest slot used
+
+void imatch_init()
+{
+	im_cl = NULL;
+	im_bounds = NULL;
+	im_blocks = 0;
+	im_top = 0;
+	im_block = imatch_block;
+#ifdef KERN_X86
+	if(kern_isa >= KERN_AVX2)
+		im_block = imatch_block_avx2;
+#endif
+}
+
+void imatch_free()
+{
+	free(im_cl);
+	free(im_bounds);
+}
+
+void imatch_grow(int id)
+{
+	// doubles the blocks until slot id fits, filling new slots as empty
+	int blocks = im_blocks;
+	while(blocks * IMATCH_LANES <= id)
+		blocks = (blocks == 0) ? 128 : blocks * 2;
+	int stride = dstate_length * IMATCH_LANES * 2;
+	im_cl = realloc(im_cl, sizeof(CL*)*blocks*IMATCH_LANES);
+	im_bounds = realloc(im_bounds, sizeof(float)*blocks*stride);
+	for(int b = im_blocks; b < blocks; b++) {
+		float *f = &im_bounds[b*stride];
+		for(int i = 0; i < dstate_length; i++) {
+			for(int j = 0; j < IMATCH_LANES; j++) {
+				f[(i*2)*IMATCH_LANES+j] = INFINITY;
+				f[(i*2+1)*IMATCH_LANES+j] = -INFINITY;
+			}
+		}
+		for(int j = 0; j < IMATCH_LANES; j++)
+			im_cl[b*IMATCH_LANES+j] = NULL;
+	}
+	im_blocks = blocks;
+}
+
+void imatch_add(CL *c)
+{
+	if(c->id >= im_blocks * IMATCH_LANES)
+		imatch_grow(c->id);
+	int b = c->id / IMATCH_LANES;
+	int j = c->id % IMATCH_LANES;
+	float *f = &im_bounds[b*dstate_length*IMATCH_LANES*2];
+	for(int i = 0; i < dstate_length; i++) {
+		f[(i*2)*IMATCH_LANES+j] = c->cond.lo[i];
+		f[(i*2+1)*IMATCH_LANES+j] = c->cond.hi[i];
+	}
+	im_cl[c->id] = c;
+	if(c->id >= im_top)
+		im_top = c->id + 1;
+}
+
+void imatch_del(CL *c)
+{
+	int b = c->id / IMATCH_LANES;
+	int j = c->id % IMATCH_LANES;
+	float *f = &im_bounds[b*dstate_length*IMATCH_LANES*2];
+	for(int i = 0; i < dstate_length; i++) {
+		f[(i*2)*IMATCH_LANES+j] = INFINITY;
+		f[(i*2+1)*IMATCH_LANES+j] = -INFINITY;
+	}
+	im_cl[c->id] = NULL;
+}
+
+void imatch_get(NODE **mset, double *dstate)
+{
+	// adds the classifiers whose intervals contain the state, found in slot
+	// order and then put in scan order
+	float x[dstate_length];
+	for(int i = 0; i < dstate_length; i++)
+		x[i] = (float)dstate[i];
+	int blocks = (im_top + IMATCH_LANES - 1) / IMATCH_LANES;
+	int stride = dstate_length * IMATCH_LANES * 2;
+	for(int b = 0; b < blocks; b++) {
+		int mask = im_block(&im_bounds[b*stride], x);
+		for(int j = 0; mask != 0; j++, mask >>= 1) {
+			if(mask & 1)
+				set_add(mset, im_cl[b*IMATCH_LANES+j]);
+		}
+	}
+	set_order(mset);
+}
+
+int imatch_block(const float *f, const float *x)
+{
+	int mask = (1 << IMATCH_LANES) - 1;
+	for(int i = 0; i < dstate_length && mask != 0; i++) {
+		const float *lo = &f[(i*2)*IMATCH_LANES];
+		const float *hi = &f[(i*2+1)*IMATCH_LANES];
+		int in = 0;
+		for(int j = 0; j < IMATCH_LANES; j++)
+			in |= ((lo[j] <= x[i]) & (x[i] <= hi[j])) << j;
+		mask &= in;
+	}
+	return mask;
+}
+
+#ifdef KERN_X86
+__attribute__((target("avx2")))
+int imatch_block_avx2(const float *f, const float *x)
+{
+	__m256 m = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	for(int i = 0; i < dstate_length; i++) {
+		__m256 v = _mm256_set1_ps(x[i]);
+		__m256 lo = _mm256_loadu_ps(&f[(i*2)*IMATCH_LANES]);
+		__m256 hi = _mm256_loadu_ps(&f[(i*2+1)*IMATCH_LANES]);
+		m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(lo, v, _CMP_LE_OQ),
+					_mm256_cmp_ps(v, hi, _CMP_LE_OQ)));
+		if(_mm256_testz_ps(m, m))
+			break;
+	}
+	return _mm256_movemask_ps(m);
+}
+#endif
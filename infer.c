@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The frozen population inference module.
+ *
+ * Compiles a population that will no longer change into an ordered decision
+ * diagram over the input bits. Each path tests only the bits specified by the
+ * classifiers still compatible with it and ends in a leaf holding the match
+ * set for every input reaching it; identical subproblems are shared so the
+ * result is a DAG. For inputs of up to INFER_TABLE_BITS bits the best action
+ * and payoff of every possible input are then tabulated. Queries follow the
+ * diagram or index the table without allocating or covering, and return the
+ * same action and payoff as building the prediction array from a scan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "pa.h"
+#include "infer.h"
+
+typedef struct MEMO {
+	int level;
+	int start; // offset of the classifier set in in_keys
+	int len;
+	int id;
+} MEMO;
+
+int infer_build(int level, int *set, int len);
+int infer_leaf(int *set, int len);
+int infer_leaf_action(int leaf, double *dstate, double *payoff);
+int infer_memo_find(int level, int *set, int len, uint64_t h);
+uint64_t infer_hash(int level, int *set, int len);
+void infer_memo_add(int level, int *set, int len, uint64_t h, int id);
+void infer_table();
+double infer_time();
+
+CL **in_cl; // frozen classifiers, oldest first as in a scanned match set
+int in_cl_num;
+int in_root; // node index, or -(leaf+1)
+int *in_bit; // decision nodes
+int *in_lo;
+int *in_hi;
+int in_nodes;
+int in_nodes_cap;
+int *lf_start; // leaves
+int *lf_len;
+int in_leaves;
+int in_leaves_cap;
+int *lf_pool; // classifier indices of all leaves
+int lf_pool_num;
+int lf_pool_cap;
+MEMO *in_memo; // shared subproblems
+int in_memo_cap;
+int in_memo_num;
+int *in_keys;
+int in_keys_num;
+int in_keys_cap;
+_Bool in_tabled;
+int *in_tact; // best action and payoff of every input
+double *in_tval;
+double *in_pa; // query scratch
+double *in_nr;
+double in_compile_time;
+void (*in_conv)(char *state, double *dstate); // real input of a binary state
+
+void infer_compile(NODE **set, void (*conv)(char *state, double *dstate))
+{
+	// compiles the given (population) set
+	double start = infer_time();
+	in_conv = conv;
+	in_cl_num = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		in_cl_num++;
+	in_cl = malloc(sizeof(CL*)*in_cl_num);
+	int i = in_cl_num;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		in_cl[--i] = iter->cl;
+	in_nodes = in_nodes_cap = 0;
+	in_leaves = in_leaves_cap = 0;
+	lf_pool_num = lf_pool_cap = 0;
+	in_bit = in_lo = in_hi = NULL;
+	lf_start = lf_len = lf_pool = NULL;
+	in_memo_cap = 1024;
+	in_memo_num = 0;
+	in_memo = malloc(sizeof(MEMO)*in_memo_cap);
+	for(i = 0; i < in_memo_cap; i++)
+		in_memo[i].len = -1;
+	in_keys_num = in_keys_cap = 0;
+	in_keys = NULL;
+	in_pa = malloc(sizeof(double)*num_actions);
+	in_nr = malloc(sizeof(double)*num_actions);
+	int *all = malloc(sizeof(int)*(in_cl_num+1));
+	for(i = 0; i < in_cl_num; i++)
+		all[i] = i;
+	in_root = infer_build(0, all, in_cl_num);
+	free(all);
+	free(in_memo);
+	free(in_keys);
+	in_tabled = false;
+	if(state_length <= INFER_TABLE_BITS)
+		infer_table();
+	in_compile_time = infer_time() - start;
+}
+
+void infer_free()
+{
+	free(in_cl);
+	free(in_bit);
+	free(in_lo);
+	free(in_hi);
+	free(lf_start);
+	free(lf_len);
+	free(lf_pool);
+	free(in_pa);
+	free(in_nr);
+	if(in_tabled) {
+		free(in_tact);
+		free(in_tval);
+	}
+}
+
+int infer_build(int level, int *set, int len)
+{
+	// skip bits no remaining classifier specifies
+	for(; level < state_length; level++) {
+		int j;
+		for(j = 0; j < len; j++) {
+			if(in_cl[set[j]]->cond.string[level] != DONT_CARE)
+				break;
+		}
+		if(j < len)
+			break;
+	}
+	uint64_t h = infer_hash(level, set, len);
+	int id = infer_memo_find(level, set, len, h);
+	if(id != INT32_MIN)
+		return id;
+	if(level == state_length)
+		id = infer_leaf(set, len);
+	else {
+		// split the set on the bit
+		int *set0 = malloc(sizeof(int)*(len+1));
+		int *set1 = malloc(sizeof(int)*(len+1));
+		int len0 = 0, len1 = 0;
+		for(int j = 0; j < len; j++) {
+			char b = in_cl[set[j]]->cond.string[level];
+			if(b != '1')
+				set0[len0++] = set[j];
+			if(b != '0')
+				set1[len1++] = set[j];
+		}
+		int lo = infer_build(level+1, set0, len0);
+		int hi = infer_build(level+1, set1, len1);
+		free(set0);
+		free(set1);
+		if(in_nodes == in_nodes_cap) {
+			in_nodes_cap = (in_nodes_cap == 0) ? 1024 : in_nodes_cap * 2;
+			in_bit = realloc(in_bit, sizeof(int)*in_nodes_cap);
+			in_lo = realloc(in_lo, sizeof(int)*in_nodes_cap);
+			in_hi = realloc(in_hi, sizeof(int)*in_nodes_cap);
+		}
+		in_bit[in_nodes] = level;
+		in_lo[in_nodes] = lo;
+		in_hi[in_nodes] = hi;
+		id = in_nodes;
+		in_nodes++;
+	}
+	infer_memo_add(level, set, len, h, id);
+	return id;
+}
+
+int infer_leaf(int *set, int len)
+{
+	if(in_leaves == in_leaves_cap) {
+		in_leaves_cap = (in_leaves_cap == 0) ? 1024 : in_leaves_cap * 2;
+		lf_start = realloc(lf_start, sizeof(int)*in_leaves_cap);
+		lf_len = realloc(lf_len, sizeof(int)*in_leaves_cap);
+	}
+	while(lf_pool_num + len > lf_pool_cap) {
+		lf_pool_cap = (lf_pool_cap == 0) ? 1024 : lf_pool_cap * 2;
+		lf_pool = realloc(lf_pool, sizeof(int)*lf_pool_cap);
+	}
+	memcpy(&lf_pool[lf_pool_num], set, sizeof(int)*len);
+	lf_start[in_leaves] = lf_pool_num;
+	lf_len[in_leaves] = len;
+	lf_pool_num += len;
+	in_leaves++;
+	return -in_leaves;
+}
+
+uint64_t infer_hash(int level, int *set, int len)
+{
+	// 64-bit FNV-1a
+	uint64_t h = 14695981039346656037ULL;
+	h = (h ^ (uint64_t)level) * 1099511628211ULL;
+	for(int i = 0; i < len; i++)
+		h = (h ^ (uint64_t)set[i]) * 1099511628211ULL;
+	return h;
+}
+
+int infer_memo_find(int level, int *set, int len, uint64_t h)
+{
+	for(int i = h % in_memo_cap; in_memo[i].len >= 0; i = (i+1) % in_memo_cap) {
+		MEMO *m = &in_memo[i];
+		if(m->level == level && m->len == len 
+				&& memcmp(&in_keys[m->start], set, sizeof(int)*len) == 0)
+			return m->id;
+	}
+	return INT32_MIN;
+}
+
+void infer_memo_add(int level, int *set, int len, uint64_t h, int id)
+{
+	if(2*(in_memo_num+1) > in_memo_cap) {
+		// rehash into a table twice the size
+		MEMO *old = in_memo;
+		int old_cap = in_memo_cap;
+		in_memo_cap *= 2;
+		in_memo = malloc(sizeof(MEMO)*in_memo_cap);
+		for(int i = 0; i < in_memo_cap; i++)
+			in_memo[i].len = -1;
+		for(int i = 0; i < old_cap; i++) {
+			if(old[i].len < 0)
+				continue;
+			uint64_t oh = infer_hash(old[i].level, &in_keys[old[i].start], old[i].len);
+			int j = oh % in_memo_cap;
+			while(in_memo[j].len >= 0)
+				j = (j+1) % in_memo_cap;
+			in_memo[j] = old[i];
+		}
+		free(old);
+	}
+	while(in_keys_num + len > in_keys_cap) {
+		in_keys_cap = (in_keys_cap == 0) ? 1024 : in_keys_cap * 2;
+		in_keys = realloc(in_keys, sizeof(int)*in_keys_cap);
+	}
+	memcpy(&in_keys[in_keys_num], set, sizeof(int)*len);
+	int i = h % in_memo_cap;
+	while(in_memo[i].len >= 0)
+		i = (i+1) % in_memo_cap;
+	in_memo[i].level = level;
+	in_memo[i].start = in_keys_num;
+	in_memo[i].len = len;
+	in_memo[i].id = id;
+	in_keys_num += len;
+	in_memo_num++;
+}
+
+void infer_table()
+{
+	// tabulates the best action and payoff of every input
+	long size = 1L << state_length;
+	in_tact = malloc(sizeof(int)*size);
+	in_tval = malloc(sizeof(double)*size);
+	char state[state_length];
+	double dstate[dstate_length];
+	for(long idx = 0; idx < size; idx++) {
+		for(int i = 0; i < state_length; i++)
+			state[i] = ((idx >> (state_length-1-i)) & 1) ? '1' : '0';
+		in_conv(state, dstate);
+		in_tact[idx] = infer_action(state, dstate, &in_tval[idx]);
+	}
+	in_tabled = true;
+}
+
+int infer_action(char *state, double *dstate, double *payoff)
+{
+	// returns the best action and its payoff for an input
+	if(in_tabled) {
+		long idx = 0;
+		for(int i = 0; i < state_length; i++)
+			idx = (idx << 1) | (state[i] == '1');
+		*payoff = in_tval[idx];
+		return in_tact[idx];
+	}
+	int n = in_root;
+	while(n >= 0)
+		n = (state[in_bit[n]] == '1') ? in_hi[n] : in_lo[n];
+	return infer_leaf_action(-n-1, dstate, payoff);
+}
+
+int infer_leaf_action(int leaf, double *dstate, double *payoff)
+{
+	// same arithmetic, in the same order, as pa_build and pa_best_action
+	_Bool present[num_actions];
+	for(int i = 0; i < num_actions; i++) {
+		in_pa[i] = 0.0;
+		in_nr[i] = 0.0;
+		present[i] = false;
+	}
+	int *set = &lf_pool[lf_start[leaf]];
+	for(int i = 0; i < lf_len[leaf]; i++) {
+		CL *c = in_cl[set[i]];
+		in_pa[c->act.a] += pred_compute(&c->pred, dstate) * c->fit;
+		in_nr[c->act.a] += c->fit;
+		present[c->act.a] = true;
+	}
+	for(int i = 0; i < num_actions; i++) {
+		if(in_nr[i] != 0.0)
+			in_pa[i] /= in_nr[i];
+		else
+			in_pa[i] = 0.0;
+	}
+	// only actions advocated by the match set compete
+	int action = -1;
+	for(int i = 0; i < num_actions; i++) {
+		if(present[i] && (action < 0 || in_pa[action] < in_pa[i]))
+			action = i;
+	}
+	if(action < 0) {
+		*payoff = 0.0;
+		return 0;
+	}
+	*payoff = in_pa[action];
+	return action;
+}
+
+int infer_verify(int samples, double *t_infer, double *t_pa)
+{
+	// checks the compiled population against the prediction array on random
+	// inputs and returns the number of disagreements; the prediction array
+	// must have been initialised
+	char state[state_length];
+	double dstate[dstate_length];
+	int errors = 0;
+	*t_infer = 0.0;
+	*t_pa = 0.0;
+	for(int n = 0; n < samples; n++) {
+		for(int i = 0; i < state_length; i++)
+			state[i] = (drand() < 0.5) ? '0' : '1';
+		in_conv(state, dstate);
+		double t0 = infer_time();
+		double payoff;
+		int action = infer_action(state, dstate, &payoff);
+		double t1 = infer_time();
+		NODE *mset = NULL;
+		pop_scan(&mset, state);
+		pa_build(&mset, dstate);
+		int best = pa_best_action();
+		double best_val = pa_best_val();
+		set_free(&mset);
+		double t2 = infer_time();
+		*t_infer += t1 - t0;
+		*t_pa += t2 - t1;
+		if(action != best || payoff != best_val)
+			errors++;
+	}
+	return errors;
+}
+
+void infer_stats(int *nodes, int *leaves, _Bool *tabled, double *time)
+{
+	*nodes = in_nodes;
+	*leaves = in_leaves;
+	*tabled = in_tabled;
+	*time = in_compile_time;
+}
+
+double infer_time()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+int infer_action(char *state, double *dstate, double *payoff);
+int infer_verify(int samples, double *t_infer, double *t_pa);
+void infer_compile(NODE **set, void (*conv)(char *state, double *dstate));
+void infer_free();
+void infer_stats(int *nodes, int *leaves, _Bool *tabled, double *time);
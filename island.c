@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The island model module.
+ *
+ * Runs ISLANDS populations in parallel, each in its own process with its own
+ * copy of the environment and its own random number stream, since a learner
+ * is held in the process globals. Every MIGRATE_EVERY trials each island
+ * sends copies of its MIGRATE_NUM fittest (or most experienced) classifiers
+ * to its neighbours on a ring or fully connected topology, and adds those it
+ * has received as offspring would be. Migrants travel through single
+ * producer, single consumer ring buffers in shared memory, one per directed
+ * edge; a full buffer drops the migrants and nothing waits.
+ *
+ * When all islands have finished, their populations are sent back to the
+ * parent which keeps the best or merges them all, then reduces the result to
+ * the population size limit and optionally runs ISLAND_CONDENSE trials of
+ * condensation (the GA without crossover or mutation). The first island
+ * writes the usual output; the others write to their own files. The time
+ * each island took to reach ISLAND_TARGET performance is reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "env.h"
+#include "perf.h"
+#include "tpool.h"
+#include "xcs.h"
+#include "exp_single_step.h"
+#include "exp_multi_step.h"
+#include "island.h"
+
+#define ISLAND_RING 4 // migrations held by each ring buffer
+
+typedef struct RING {
+	atomic_long head; // records written
+	atomic_long tail; // records read
+} RING;
+
+typedef struct ISLAND {
+	double target_time; // seconds to reach the target (-1 = never)
+	int target_trial;
+	double perf; // final performance
+	double time; // seconds to finish
+	long sent;
+	long received;
+	long dropped;
+} ISLAND;
+
+_Bool island_reached(double perf);
+_Bool island_edge(int from, int to);
+double island_perf(int *perf);
+double island_time();
+int island_cmp(const void *a, const void *b);
+void island_export(int island);
+void island_import(int island, int time);
+void island_run(XCS *xcs, int island, int exp_num, int *perf, double *err, 
+		int fd);
+
+ISLAND *is_info; // shared results of each island
+RING *is_ring; // shared ring of each directed edge [from*ISLANDS+to]
+char *is_data; // shared ring records
+size_t is_cl_size; // bytes per saved classifier
+int is_ring_cap; // records per ring
+double is_start;
+CL **is_sel; // the population sorted for selecting migrants
+int is_sel_cap;
+
+void island_exp(XCS *xcs, int exp_num, int *perf, double *err)
+{
+	// size the shared memory
+	CL *c = malloc(sizeof(CL));
+	cl_init(c, 0, 0);
+	is_cl_size = cl_save(c, NULL);
+	cl_free(c);
+	is_ring_cap = ISLAND_RING * MIGRATE_NUM;
+	size_t edges = ISLANDS * ISLANDS;
+	size_t size = sizeof(ISLAND)*ISLANDS + sizeof(RING)*edges 
+		+ is_cl_size*is_ring_cap*edges;
+	char *shm = mmap(NULL, size, PROT_READ | PROT_WRITE, 
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(shm == MAP_FAILED) {
+		printf("Error allocating island memory\n");
+		exit(EXIT_FAILURE);
+	}
+	is_info = (ISLAND *)shm;
+	is_ring = (RING *)(shm + sizeof(ISLAND)*ISLANDS);
+	is_data = shm + sizeof(ISLAND)*ISLANDS + sizeof(RING)*edges;
+	for(size_t i = 0; i < edges; i++) {
+		atomic_init(&is_ring[i].head, 0);
+		atomic_init(&is_ring[i].tail, 0);
+	}
+
+	// start the islands
+	unsigned long seed = irand(1, INT_MAX);
+	int fds[ISLANDS];
+	pid_t pids[ISLANDS];
+	perf_drain();
+	fflush(NULL);
+	// threads do not survive fork(), so each island starts its own pool
+	tpool_free();
+	is_start = island_time();
+	for(int i = 0; i < ISLANDS; i++) {
+		int p[2];
+		if(pipe(p) != 0 || (pids[i] = fork()) < 0) {
+			printf("Error starting island %d\n", i);
+			exit(EXIT_FAILURE);
+		}
+		if(pids[i] == 0) {
+			close(p[0]);
+			tpool_init(NUM_THREADS);
+			random_seed(seed + i);
+			island_run(xcs, i, exp_num, perf, err, p[1]);
+		}
+		close(p[1]);
+		fds[i] = p[0];
+	}
+
+	// collect the populations
+	char *buf[ISLANDS];
+	size_t len[ISLANDS];
+	for(int i = 0; i < ISLANDS; i++) {
+		size_t cap = 1 << 16;
+		buf[i] = malloc(cap);
+		len[i] = 0;
+		ssize_t n;
+		while((n = read(fds[i], buf[i]+len[i], cap-len[i])) > 0) {
+			len[i] += n;
+			if(len[i] == cap) {
+				cap *= 2;
+				buf[i] = realloc(buf[i], cap);
+			}
+		}
+		close(fds[i]);
+	}
+	for(int i = 0; i < ISLANDS; i++)
+		waitpid(pids[i], NULL, 0);
+	tpool_init(NUM_THREADS);
+
+	// report
+	int best = 0;
+	double first = -1.0;
+	for(int i = 0; i < ISLANDS; i++) {
+		ISLAND *is = &is_info[i];
+		if(is->target_time >= 0.0) {
+			printf("island %d: target %.2f after %d trials, %.3fs", 
+					i, ISLAND_TARGET, is->target_trial, is->target_time);
+			if(first < 0.0 || is->target_time < first)
+				first = is->target_time;
+		}
+		else
+			printf("island %d: target %.2f not reached", i, ISLAND_TARGET);
+		printf(", final %.5f in %.3fs, migrants %ld sent %ld received %ld dropped\n",
+				is->perf, is->time, is->sent, is->received, is->dropped);
+		if(multi_step ? is->perf < is_info[best].perf 
+				: is->perf > is_info[best].perf)
+			best = i;
+	}
+	if(first >= 0.0)
+		printf("islands: %d, target first reached after %.3fs\n", ISLANDS, first);
+	else
+		printf("islands: %d, target not reached\n", ISLANDS);
+
+	// merge and condense
+	if(ISLAND_MERGE == 0)
+		xcs_load(xcs, buf[best], len[best]);
+	else {
+		xcs_load(xcs, buf[0], len[0]);
+		for(int i = 1; i < ISLANDS; i++)
+			xcs_merge(xcs, buf[i], len[i]);
+	}
+	for(int i = 0; i < ISLANDS; i++)
+		free(buf[i]);
+	NODE *kset = NULL;
+	pop_enforce_limit(&kset);
+	set_kill(&kset);
+	if(ISLAND_CONDENSE > 0) {
+		double p_crossover = P_CROSSOVER, p_mutation = P_MUTATION;
+		P_CROSSOVER = 0.0;
+		P_MUTATION = 0.0;
+		if(multi_step) {
+			// continue the step count from the newest classifier
+			int step = 0;
+			for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+				if(iter->cl->time > step)
+					step = iter->cl->time;
+			}
+			multi_step_run(MAX_TRIALS, MAX_TRIALS+ISLAND_CONDENSE, step, perf, err);
+		}
+		else
+			single_step_run(xcs, MAX_TRIALS, MAX_TRIALS+ISLAND_CONDENSE, perf, err);
+		P_CROSSOVER = p_crossover;
+		P_MUTATION = p_mutation;
+	}
+	printf("islands: final population %d macro, %d micro classifiers\n", 
+			pop_num, pop_num_sum);
+	munmap(shm, size);
+}
+
+void island_run(XCS *xcs, int island, int exp_num, int *perf, double *err, 
+		int fd)
+{
+	// runs in the island's own process and does not return
+	ISLAND *is = &is_info[island];
+	is->target_time = -1.0;
+	is->target_trial = 0;
+	is->sent = 0;
+	is->received = 0;
+	is->dropped = 0;
+	is_sel = NULL;
+	is_sel_cap = 0;
+	if(island > 0) {
+		freopen("/dev/null", "w", stdout);
+		outfile_close();
+		outfile_init_island(exp_num, island);
+	}
+	int every = (MIGRATE_EVERY > 0) ? MIGRATE_EVERY : MAX_TRIALS;
+	int step = 0;
+	for(int t = 0; t < MAX_TRIALS; t += every) {
+		int end = (t + every < MAX_TRIALS) ? t + every : MAX_TRIALS;
+		if(multi_step)
+			step = multi_step_run(t, end, step, perf, err);
+		else
+			single_step_run(xcs, t, end, perf, err);
+		if(is->target_time < 0.0 && end >= PERF_AVG_TRIALS 
+				&& island_reached(island_perf(perf))) {
+			is->target_time = island_time() - is_start;
+			is->target_trial = end;
+		}
+		if(ISLANDS > 1 && end < MAX_TRIALS) {
+			island_export(island);
+			island_import(island, end);
+		}
+	}
+	is->perf = island_perf(perf);
+	is->time = island_time() - is_start;
+	// send the population back
+	size_t size = xcs_save(xcs, NULL, 0);
+	char *buf = malloc(size);
+	xcs_save(xcs, buf, size);
+	for(size_t n = 0; n < size; ) {
+		ssize_t w = write(fd, buf+n, size-n);
+		if(w <= 0)
+			break;
+		n += w;
+	}
+	close(fd);
+	free(is_sel);
+	perf_drain();
+	fflush(NULL);
+	_exit(EXIT_SUCCESS);
+}
+
+_Bool island_edge(int from, int to)
+{
+	if(from == to)
+		return false;
+	if(MIGRATE_TOPOLOGY == 1)
+		return true;
+	return to == (from + 1) % ISLANDS;
+}
+
+int island_cmp(const void *a, const void *b)
+{
+	// descending fitness or experience
+	CL *c1 = *(CL **)a;
+	CL *c2 = *(CL **)b;
+	if(MIGRATE_SELECT == 1)
+		return (c1->exp < c2->exp) - (c1->exp > c2->exp);
+	return (c1->fit < c2->fit) - (c1->fit > c2->fit);
+}
+
+void island_export(int island)
+{
+	// copies of the best classifiers to every neighbour
+	if(pop_num >= is_sel_cap) {
+		is_sel_cap = 2 * (pop_num + 1);
+		is_sel = realloc(is_sel, sizeof(CL*)*is_sel_cap);
+	}
+	CL **cl = is_sel;
+	int n = 0;
+	for(NODE *iter = pset; iter != NULL; iter = iter->next)
+		cl[n++] = iter->cl;
+	qsort(cl, n, sizeof(CL*), island_cmp);
+	if(n > MIGRATE_NUM)
+		n = MIGRATE_NUM;
+	for(int to = 0; to < ISLANDS; to++) {
+		if(!island_edge(island, to))
+			continue;
+		int e = island*ISLANDS+to;
+		RING *r = &is_ring[e];
+		for(int i = 0; i < n; i++) {
+			long head = atomic_load_explicit(&r->head, memory_order_relaxed);
+			long tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+			if(head - tail == is_ring_cap) {
+				is_info[island].dropped += n - i;
+				break;
+			}
+			char *rec = &is_data[(e*is_ring_cap + head%is_ring_cap)*is_cl_size];
+			cl_save(cl[i], rec);
+			atomic_store_explicit(&r->head, head+1, memory_order_release);
+			is_info[island].sent++;
+		}
+	}
+}
+
+void island_import(int island, int time)
+{
+	// adds the migrants received as single new offspring
+	for(int from = 0; from < ISLANDS; from++) {
+		if(!island_edge(from, island))
+			continue;
+		int e = from*ISLANDS+island;
+		RING *r = &is_ring[e];
+		long tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+		long head = atomic_load_explicit(&r->head, memory_order_acquire);
+		for(; tail < head; tail++) {
+			char *rec = &is_data[(e*is_ring_cap + tail%is_ring_cap)*is_cl_size];
+			CL *c = malloc(sizeof(CL));
+			cl_init(c, 0, time);
+			cl_load(c, rec);
+			c->num = 1;
+			c->time = time;
+			pop_add(c);
+			is_info[island].received++;
+		}
+		atomic_store_explicit(&r->tail, tail, memory_order_release);
+	}
+	NODE *kset = NULL;
+	pop_enforce_limit(&kset);
+	set_kill(&kset);
+}
+
+double island_perf(int *perf)
+{
+	// fraction correct, or steps to the goal in multi-step problems
+	double sum = 0.0;
+	for(int i = 0; i < PERF_AVG_TRIALS; i++)
+		sum += perf[i];
+	return sum / PERF_AVG_TRIALS;
+}
+
+_Bool island_reached(double perf)
+{
+	if(multi_step)
+		return perf <= ISLAND_TARGET;
+	return perf >= ISLAND_TARGET;
+}
+
+double island_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The specialised kernel module.
+ *
+ * Instantiates the ternary match and the computed prediction kernels for the
+ * common fixed input lengths (the multiplexer, maze and small real-valued
+ * problems) so that the compiler sees constant trip counts and can unroll
+ * and vectorise them. The specialised match is branch-free: with a constant
+ * length, comparing every bit is cheaper than the mispredicted early exit.
+ * The kernels are selected once when the lengths are known with a generic
+ * fallback for all other sizes.
+ *
+ * Every kernel is compiled for the baseline instruction set and, on x86, for
+ * AVX2 and AVX-512. The variant is chosen from the running processor unless
+ * the XCS_KERN environment variable (x86-64, avx2 or avx512) forces one that
+ * the processor supports.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "kern.h"
+
+#define KERN_MATCH(V, L) \
+static _Bool kern_match_##L##_##V(const char *cond, const char *state) \
+{ \
+	const char dc = DONT_CARE; \
+	char bad = 0; \
+	for(int i = 0; i < L; i++) \
+		bad |= (cond[i] != dc) & (cond[i] != state[i]); \
+	return !bad; \
+}
+
+#ifdef QUADRATIC
+#define KERN_EVAL_QUAD(D) \
+	for(int i = 0; i < D; i++) \
+		for(int j = i; j < D; j++) \
+			pre += w[index++] * state[i] * state[j];
+#define KERN_UPDATE_QUAD(D) \
+	for(int i = 0; i < D; i++) \
+		for(int j = i; j < D; j++) \
+			w[index++] += correction * state[i] * state[j];
+#else
+#define KERN_EVAL_QUAD(D)
+#define KERN_UPDATE_QUAD(D)
+#endif
+
+// same coefficient layout and summation order as the generic versions; the
+// sums are kept in double when the weights are stored as float
+#define KERN_PRED(V, D, N) \
+static double kern_eval_##N##_##V(const REAL *w, const double *state) \
+{ \
+	double pre = XCSF_X0 * w[0]; \
+	int index = 1; \
+	for(int i = 0; i < D; i++) \
+		pre += w[index++] * state[i]; \
+	KERN_EVAL_QUAD(D) \
+	return pre; \
+} \
+static void kern_update_##N##_##V(REAL *w, const double *state, double error) \
+{ \
+	double norm = XCSF_X0 * XCSF_X0; \
+	for(int i = 0; i < D; i++) \
+		norm += state[i] * state[i]; \
+	double correction = (XCSF_ETA * error) / norm; \
+	w[0] += XCSF_X0 * correction; \
+	int index = 1; \
+	for(int i = 0; i < D; i++) \
+		w[index++] += correction * state[i]; \
+	KERN_UPDATE_QUAD(D) \
+}
+
+// long strings mostly fail early so the generic match keeps the early exit
+#define KERN_MATCH_ANY(V) \
+static _Bool kern_match_any_##V(const char *cond, const char *state) \
+{ \
+	for(int i = 0; i < state_length; i++) { \
+		if(cond[i] != DONT_CARE && cond[i] != state[i]) \
+			return false; \
+	} \
+	return true; \
+}
+
+// the recursive least squares gain matrix update: (I - gain input') matrix
+#define KERN_RLS(V) \
+static void kern_rls_##V(REAL *matrix, const double *gain, \
+		const double *input, double lambda, int n) \
+{ \
+	double tmp1[n*n]; \
+	double tmp2[n*n]; \
+	for(int i = 0; i < n; i++) { \
+		for(int j = 0; j < n; j++) { \
+			double tmp = gain[i] * input[j]; \
+			tmp1[i*n+j] = (i == j) ? 1.0 - tmp : -tmp; \
+		} \
+	} \
+	for(int i = 0; i < n; i++) { \
+		/* same order of terms per entry, but along contiguous rows */ \
+		for(int j = 0; j < n; j++) \
+			tmp2[i*n+j] = tmp1[i*n] * matrix[j]; \
+		for(int k = 1; k < n; k++) { \
+			for(int j = 0; j < n; j++) \
+				tmp2[i*n+j] += tmp1[i*n+k] * matrix[k*n+j]; \
+		} \
+	} \
+	for(int i = 0; i < n*n; i++) \
+		matrix[i] = tmp2[i] / lambda; \
+}
+
+#define KERN_ISA(V) \
+KERN_MATCH(V, 6) \
+KERN_MATCH(V, 11) \
+KERN_MATCH(V, 20) \
+KERN_MATCH(V, 37) \
+KERN_MATCH(V, 70) \
+KERN_MATCH(V, 135) \
+KERN_MATCH(V, 16) \
+KERN_MATCH(V, 24) \
+KERN_MATCH_ANY(V) \
+KERN_PRED(V, 6, 6) \
+KERN_PRED(V, 8, 8) \
+KERN_PRED(V, 11, 11) \
+KERN_PRED(V, dstate_length, any) \
+KERN_RLS(V) \
+static void kern_select_##V() \
+{ \
+	switch(state_length) { \
+		case 6: kern_match = kern_match_6_##V; break; \
+		case 11: kern_match = kern_match_11_##V; break; \
+		case 16: kern_match = kern_match_16_##V; break; \
+		case 20: kern_match = kern_match_20_##V; break; \
+		case 24: kern_match = kern_match_24_##V; break; \
+		case 37: kern_match = kern_match_37_##V; break; \
+		case 70: kern_match = kern_match_70_##V; break; \
+		case 135: kern_match = kern_match_135_##V; break; \
+		default: kern_match = kern_match_any_##V; break; \
+	} \
+	switch(dstate_length) { \
+		case 6: kern_eval = kern_eval_6_##V; \
+			kern_update = kern_update_6_##V; break; \
+		case 8: kern_eval = kern_eval_8_##V; \
+			kern_update = kern_update_8_##V; break; \
+		case 11: kern_eval = kern_eval_11_##V; \
+			kern_update = kern_update_11_##V; break; \
+		default: kern_eval = kern_eval_any_##V; \
+			kern_update = kern_update_any_##V; break; \
+	} \
+	kern_rls = kern_rls_##V; \
+}
+
+// multiplexer (6-135), maze with 2 and 3 bits per neighbouring cell (16, 24)
+// and real inputs or the multiplexer bits used as prediction inputs (6-11)
+KERN_ISA(base)
+#ifdef KERN_X86
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+KERN_ISA(avx2)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vl,avx2,fma")
+KERN_ISA(avx512)
+#pragma GCC pop_options
+#endif
+
+const char *kern_names[] = {"x86-64", "avx2", "avx512"};
+
+_Bool kern_supported(int isa);
+
+const char *kern_name()
+{
+	return kern_names[kern_isa];
+}
+
+_Bool kern_supported(int isa)
+{
+#ifdef KERN_X86
+	__builtin_cpu_init();
+	if(isa == KERN_AVX512)
+		return __builtin_cpu_supports("avx512f") 
+			&& __builtin_cpu_supports("avx512bw")
+			&& __builtin_cpu_supports("avx512vl")
+			&& __builtin_cpu_supports("fma");
+	if(isa == KERN_AVX2)
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	return isa == KERN_BASE;
+}
+
+void kern_init()
+{
+	// the widest supported variant unless a supported one is forced
+	kern_isa = KERN_BASE;
+	for(int i = KERN_AVX512; i > KERN_BASE; i--) {
+		if(kern_supported(i)) {
+			kern_isa = i;
+			break;
+		}
+	}
+	char *force = getenv("XCS_KERN");
+	if(force != NULL) {
+		for(int i = KERN_BASE; i <= KERN_AVX512; i++) {
+			if(strcmp(force, kern_names[i]) == 0 && kern_supported(i))
+				kern_isa = i;
+		}
+	}
+	switch(kern_isa) {
+#ifdef KERN_X86
+		case KERN_AVX512: kern_select_avx512(); break;
+		case KERN_AVX2: kern_select_avx2(); break;
+#endif
+		default: kern_select_base(); break;
+	}
+}
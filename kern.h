@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERN_X86
+#endif
+
+#define KERN_BASE 0
+#define KERN_AVX2 1
+#define KERN_AVX512 2
+
+int kern_isa; // instruction set variant of the active kernels
+_Bool (*kern_match)(const char *cond, const char *state);
+double (*kern_eval)(const REAL *w, const double *state);
+void (*kern_update)(REAL *w, const double *state, double error);
+void (*kern_rls)(REAL *matrix, const double *gain, const double *input, 
+		double lambda, int n);
+const char *kern_name();
+void kern_init();
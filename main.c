@@ -22,14 +22,29 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "cons.h"
 #include "random.h"
 #include "cl.h"
 #include "cl_set.h"
 #include "env.h"
 #include "perf.h"
+#include "mcache.h"
+#include "batch.h"
+#include "ga_async.h"
+#include "infer.h"
+#include "xcs.h"
 #include "exp_single_step.h"
 #include "exp_multi_step.h"
+#include "island.h"
+#include "hogwild.h"
+#include "kern.h"
+#include "sweep.h"
+
+void print_batch();
+void print_ga_async();
+void print_match_cache();
+void print_inference();
 
 int main(int argc, char *argv[0])
 {    
@@ -39,26 +54,104 @@ int main(int argc, char *argv[0])
 	} 
 
 	// initialise environment
-	constants_init(argc, argv);
+	XCS_PARAMS p;
+	constants_init(argc, argv, &p);
 	random_init();
 	env_init(argv);
+	p.state_length = state_length;
+	p.dstate_length = dstate_length;
+	p.num_actions = num_actions;
 	gen_outfname();
+	if(COND_TYPE != 0 && INFER_VERIFY > 0) {
+		printf("INFER_VERIFY needs COND_TYPE=0\n");
+		exit(EXIT_FAILURE);
+	}
+	if(strcmp(SWEEP, "none") != 0) {
+		sweep_exp(argc, argv);
+		env_free();
+		return EXIT_SUCCESS;
+	}
 
 	// run experiments
 	int perf[PERF_AVG_TRIALS];
 	double err[PERF_AVG_TRIALS];
 	for(int e = 1; e < NUM_EXPERIMENTS+1; e++) {
 		printf("\nExperiment: %d\n", e);
-		pop_init();
+		XCS *xcs = xcs_create(&p);
+		if(xcs == NULL) {
+			printf("Error creating the learner\n");
+			exit(EXIT_FAILURE);
+		}
+		printf("kernels: %s\n", kern_name());
 		outfile_init(e);
-		if(!multi_step)
-			single_step_exp(perf, err);
+		if(ISLANDS > 0)
+			island_exp(xcs, e, perf, err);
+		else if(HOGWILD > 0)
+			hogwild_exp(perf, err);
+		else if(!multi_step)
+			single_step_exp(xcs, perf, err);
 		else
 			multi_step_exp(perf, err);
+		perf_drain();
 		// clean up
-		set_kill(&pset);
+		if(MATCH_CACHE_SIZE > 0)
+			print_match_cache();
+		if(BATCH_SIZE > 1 && !multi_step)
+			print_batch();
+		if(GA_QUEUE > 0)
+			print_ga_async();
+		if(INFER_VERIFY > 0)
+			print_inference();
+		xcs_destroy(xcs);
 		outfile_close();
 	}
 	env_free();
 	return EXIT_SUCCESS;
 }
+
+void print_batch()
+{
+	long covers, shared, sets, stale;
+	batch_stats(&covers, &shared, &sets, &stale);
+	printf("batch: %d inputs, %ld covering classifiers (%ld reuses), "
+			"%ld deferred action sets, %ld members removed before their turn\n",
+			BATCH_SIZE, covers, shared, sets, stale);
+}
+
+void print_ga_async()
+{
+	long jobs, waits, lost, sync;
+	double lag;
+	ga_async_stats(&jobs, &waits, &lag, &lost, &sync);
+	printf("async GA: %ld runs applied %.1f steps late on average, "
+			"%ld waits for the GA thread, %ld subsumers lost\n",
+			jobs, lag, waits, lost);
+	if(sync > 0)
+		printf("async GA: the GA thread could not be started, "
+				"%ld runs made synchronously\n", sync);
+}
+
+void print_match_cache()
+{
+	long hits, misses;
+	mcache_stats(&hits, &misses);
+	long total = hits + misses;
+	printf("match cache: %ld hits, %ld misses (%.2f%% hit rate)\n",
+			hits, misses, total > 0 ? 100.0 * hits / total : 0.0);
+}
+
+void print_inference()
+{
+	// compile the final population and check it against the prediction array
+	int nodes, leaves;
+	_Bool tabled;
+	double t_compile, t_infer, t_pa;
+	infer_compile(&pset, env_conv_dstate);
+	int errors = infer_verify(INFER_VERIFY, &t_infer, &t_pa);
+	infer_stats(&nodes, &leaves, &tabled, &t_compile);
+	printf("inference: %d nodes, %d leaves, %s, compiled in %.3fs\n",
+			nodes, leaves, tabled ? "tabled" : "not tabled", t_compile);
+	printf("inference: %d/%d mismatches, %.3fus per query vs %.3fus\n",
+			errors, INFER_VERIFY, 1e6*t_infer/INFER_VERIFY, 1e6*t_pa/INFER_VERIFY);
+	infer_free();
+}
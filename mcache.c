@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The match set cache module.
+ *
+ * Remembers the classifiers matching recently seen input states in a direct
+ * mapped table indexed by a hash of the state. Each entry is patched whenever
+ * a macro-classifier is added to or removed from the population so that a
+ * cached match set is always identical (including order) to the one that
+ * would be produced by scanning the population. Useful where only a small
+ * number of distinct states are perceived, e.g., the maze environments.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "mcache.h"
+
+typedef struct MCACHE {
+	_Bool valid;
+	char *state;
+	CL **cl; // matching classifiers, oldest first
+	int size;
+	int cap;
+} MCACHE;
+
+uint64_t mcache_hash(char *state);
+void mcache_append(MCACHE *e, CL *c);
+
+MCACHE *mcache;
+long mcache_hits;
+long mcache_misses;
+
+void mcache_init()
+{
+	mcache = malloc(sizeof(MCACHE)*MATCH_CACHE_SIZE);
+	for(int i = 0; i < MATCH_CACHE_SIZE; i++) {
+		mcache[i].valid = false;
+		mcache[i].state = malloc(sizeof(char)*state_length);
+		mcache[i].cl = NULL;
+		mcache[i].size = 0;
+		mcache[i].cap = 0;
+	}
+	mcache_hits = 0;
+	mcache_misses = 0;
+}
+
+void mcache_free()
+{
+	for(int i = 0; i < MATCH_CACHE_SIZE; i++) {
+		free(mcache[i].state);
+		free(mcache[i].cl);
+	}
+	free(mcache);
+}
+
+uint64_t mcache_hash(char *state)
+{
+	// 64-bit FNV-1a
+	uint64_t h = 14695981039346656037ULL;
+	for(int i = 0; i < state_length; i++) {
+		h ^= (unsigned char)state[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+_Bool mcache_get(NODE **mset, char *state)
+{
+	// builds the match set from the cache if the state is present
+	MCACHE *e = &mcache[mcache_hash(state) % MATCH_CACHE_SIZE];
+	if(!e->valid || memcmp(e->state, state, state_length) != 0) {
+		mcache_misses++;
+		return false;
+	}
+	// set_add prepends, so add newest first to reproduce the scan order
+	for(int i = e->size-1; i >= 0; i--)
+		set_add(mset, e->cl[i]);
+	mcache_hits++;
+	return true;
+}
+
+void mcache_put(NODE **mset, char *state)
+{
+	// stores a freshly scanned match set, replacing any colliding entry
+	MCACHE *e = &mcache[mcache_hash(state) % MATCH_CACHE_SIZE];
+	memcpy(e->state, state, sizeof(char)*state_length);
+	e->size = 0;
+	for(NODE *iter = *mset; iter != NULL; iter = iter->next)
+		mcache_append(e, iter->cl);
+	e->valid = true;
+}
+
+void mcache_append(MCACHE *e, CL *c)
+{
+	if(e->size == e->cap) {
+		e->cap = (e->cap == 0) ? 16 : e->cap * 2;
+		e->cl = realloc(e->cl, sizeof(CL*)*e->cap);
+	}
+	e->cl[e->size] = c;
+	e->size++;
+}
+
+void mcache_add(CL *c)
+{
+	// a new macro-classifier has been added to the population
+	for(int i = 0; i < MATCH_CACHE_SIZE; i++) {
+		MCACHE *e = &mcache[i];
+		if(e->valid && cond_match(&c->cond, e->state, NULL))
+			mcache_append(e, c);
+	}
+}
+
+void mcache_del(CL *c)
+{
+	// a macro-classifier has been removed from the population
+	for(int i = 0; i < MATCH_CACHE_SIZE; i++) {
+		MCACHE *e = &mcache[i];
+		if(!e->valid)
+			continue;
+		for(int j = 0; j < e->size; j++) {
+			if(e->cl[j] == c) {
+				memmove(&e->cl[j], &e->cl[j+1], sizeof(CL*)*(e->size-j-1));
+				e->size--;
+				break;
+			}
+		}
+	}
+}
+
+void mcache_stats(long *hits, long *misses)
+{
+	*hits = mcache_hits;
+	*misses = mcache_misses;
+}
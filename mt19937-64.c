@@ -64,10 +64,10 @@
 #define LM 0x7FFFFFFFULL /* Least significant 31 bits */
 
 
-/* The array for the state vector */
-static unsigned long long mt[NN]; 
+/* The array for the state vector; one generator per thread */
+static _Thread_local unsigned long long mt[NN]; 
 /* mti==NN+1 means mt[NN] is not initialized */
-static int mti=NN+1; 
+static _Thread_local int mti=NN+1; 
 
 /* initializes mt[NN] with a seed */
 void init_genrand64(unsigned long long seed)
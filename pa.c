@@ -18,6 +18,11 @@
  * Description: 
  **************
  * The prediction array module.
+ *
+ * The array is sparse in use: only the actions advocated by the current
+ * match set are cleared, filled and searched, so a step costs time in the
+ * number of distinct actions in the match set rather than num_actions. The
+ * entries of other actions stay 0.
  */
 
 #include <stdio.h>
@@ -29,60 +34,175 @@
 #include "cl.h"
 #include "cl_set.h"
 #include "pa.h"
+#include "tpool.h"
+
+#define PA_CHUNK 64 // match set classifiers per parallel chunk
+
+void pa_build_chunk(int chunk, void *state);
+void pa_build_par(double *state);
 
 double *pa;
 double *nr; 
+CL **pa_set; // match set flattened
+int pa_set_size;
+int pa_set_cap;
+double *pa_part; // per chunk (pa, nr) partial sums
+int pa_part_cap;
+CL ***pa_bkt; // match set classifiers advocating each action
+int *pa_bkt_size;
+int *pa_bkt_cap;
+int *pa_bkt_num; // numerosity sum of each bucket
+int *pa_acts; // actions with a non-empty bucket
+int pa_acts_num;
 
 void pa_init()
 {
 	pa = malloc(sizeof(double)*num_actions);
 	nr = malloc(sizeof(double)*num_actions);
+	pa_set = NULL;
+	pa_set_cap = 0;
+	pa_part = NULL;
+	pa_part_cap = 0;
+	pa_bkt = malloc(sizeof(CL**)*num_actions);
+	pa_bkt_size = malloc(sizeof(int)*num_actions);
+	pa_bkt_cap = malloc(sizeof(int)*num_actions);
+	pa_bkt_num = malloc(sizeof(int)*num_actions);
+	pa_acts = malloc(sizeof(int)*num_actions);
+	for(int i = 0; i < num_actions; i++) {
+		pa[i] = 0.0;
+		nr[i] = 0.0;
+		pa_bkt[i] = NULL;
+		pa_bkt_size[i] = 0;
+		pa_bkt_cap[i] = 0;
+		pa_bkt_num[i] = 0;
+	}
+	pa_acts_num = 0;
 }
 
 void pa_build(NODE **set, double *state)
 {
-	for(int i = 0; i < num_actions; i++) {
-		pa[i] = 0.0;
-		nr[i] = 0.0;
+	// one pass over the match set buckets the classifiers by action, then the
+	// predictions are computed once each and accumulated
+	pa_set_size = 0;
+	for(int i = 0; i < pa_acts_num; i++) {
+		int a = pa_acts[i];
+		pa[a] = 0.0;
+		nr[a] = 0.0;
+		pa_bkt_size[a] = 0;
+		pa_bkt_num[a] = 0;
 	}
+	pa_acts_num = 0;
 	for(NODE *iter = *set; iter != NULL; iter = iter->next) {
 		CL *c = iter->cl;
-		pa[c->act.a] += pred_compute(&c->pred, state) * c->fit;
-		nr[c->act.a] += c->fit;
+		int a = c->act.a;
+		if(pa_set_size == pa_set_cap) {
+			pa_set_cap = (pa_set_cap == 0) ? 64 : pa_set_cap * 2;
+			pa_set = realloc(pa_set, sizeof(CL*)*pa_set_cap);
+		}
+		pa_set[pa_set_size++] = c;
+		if(pa_bkt_size[a] == pa_bkt_cap[a]) {
+			pa_bkt_cap[a] = (pa_bkt_cap[a] == 0) ? 16 : pa_bkt_cap[a] * 2;
+			pa_bkt[a] = realloc(pa_bkt[a], sizeof(CL*)*pa_bkt_cap[a]);
+		}
+		if(pa_bkt_size[a] == 0)
+			pa_acts[pa_acts_num++] = a;
+		pa_bkt[a][pa_bkt_size[a]++] = c;
+		pa_bkt_num[a] += c->num;
 	}
-	for(int i = 0; i < num_actions; i++) {
-		if(nr[i] != 0.0)
-			pa[i] /= nr[i];
+	if(pa_set_size >= PAR_PA_MIN)
+		pa_build_par(state);
+	else {
+		for(int i = 0; i < pa_set_size; i++) {
+			CL *c = pa_set[i];
+			pa[c->act.a] += pred_compute(&c->pred, state) * c->fit;
+			nr[c->act.a] += c->fit;
+		}
+	}
+	for(int i = 0; i < pa_acts_num; i++) {
+		int a = pa_acts[i];
+		if(nr[a] != 0.0)
+			pa[a] /= nr[a];
 		else
-			pa[i] = 0.0;
+			pa[a] = 0.0;
+	}
+}
+
+void pa_build_par(double *state)
+{
+	// each fixed size chunk of the match set is summed separately and the
+	// partial sums are reduced in chunk order so that the result does not
+	// depend on the number of threads
+	int chunks = (pa_set_size + PA_CHUNK - 1) / PA_CHUNK;
+	if(chunks > pa_part_cap) {
+		pa_part_cap = chunks;
+		pa_part = realloc(pa_part, sizeof(double)*2*num_actions*chunks);
+	}
+	tpool_run(pa_build_chunk, state, chunks);
+	for(int j = 0; j < chunks; j++) {
+		double *part = &pa_part[2*num_actions*j];
+		for(int i = 0; i < pa_acts_num; i++) {
+			int a = pa_acts[i];
+			pa[a] += part[a];
+			nr[a] += part[num_actions+a];
+		}
+	}
+}
+
+void pa_build_chunk(int chunk, void *state)
+{
+	double *part = &pa_part[2*num_actions*chunk];
+	for(int i = 0; i < pa_acts_num; i++) {
+		part[pa_acts[i]] = 0.0;
+		part[num_actions+pa_acts[i]] = 0.0;
+	}
+	int end = (chunk+1) * PA_CHUNK;
+	if(end > pa_set_size)
+		end = pa_set_size;
+	for(int i = chunk * PA_CHUNK; i < end; i++) {
+		CL *c = pa_set[i];
+		part[c->act.a] += pred_compute(&c->pred, state) * c->fit;
+		part[num_actions+c->act.a] += c->fit;
 	}
 }
 
 int pa_best_action()
 {
-	int action = 0;
-	for(int i = 1; i < num_actions; i++) {
-		if(pa[action] < pa[i])
-			action = i;
+	// the lowest numbered of the best advocated actions, or 0 for an empty
+	// match set
+	if(pa_acts_num == 0)
+		return 0;
+	int action = pa_acts[0];
+	for(int i = 1; i < pa_acts_num; i++) {
+		int a = pa_acts[i];
+		if(pa[action] < pa[a] || (pa[action] == pa[a] && a < action))
+			action = a;
 	}
 	return action;
 }
 
 int pa_rand_action()
 {
-	int action = 0;
-	do {
-		action = irand(0, num_actions);
-	} while(nr[action] == 0);
-	return action;
+	// uniform over the actions advocated in the match set
+	return pa_acts[irand(0, pa_acts_num)];
+}
+
+int pa_set_action(NODE **aset, int action, int *num)
+{
+	// builds the action set from the bucket filled by pa_build
+	for(int i = 0; i < pa_bkt_size[action]; i++)
+		set_add(aset, pa_bkt[action][i]);
+	*num += pa_bkt_num[action];
+	return pa_bkt_size[action];
 }
 
 double pa_best_val()
 {
-	double max = pa[0];
-	for(int i = 1; i < num_actions; i++) {
-		if(max < pa[i])
-			max = pa[i];
+	if(pa_acts_num == 0)
+		return 0.0;
+	double max = pa[pa_acts[0]];
+	for(int i = 1; i < pa_acts_num; i++) {
+		if(max < pa[pa_acts[i]])
+			max = pa[pa_acts[i]];
 	}
 	return max;
 }
@@ -98,4 +218,13 @@ void pa_free()
 {
 	free(pa);
 	free(nr);
+	free(pa_set);
+	free(pa_part);
+	for(int i = 0; i < num_actions; i++)
+		free(pa_bkt[i]);
+	free(pa_bkt);
+	free(pa_bkt_size);
+	free(pa_bkt_cap);
+	free(pa_bkt_num);
+	free(pa_acts);
 }
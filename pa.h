@@ -20,5 +20,6 @@ double pa_best_val();
 double pa_val(int act);   
 int pa_best_action();
 int pa_rand_action();
+int pa_set_action(NODE **aset, int action, int *num);
 void pa_init();
 void pa_free();
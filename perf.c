@@ -19,22 +19,68 @@
  **************
  * The performance output module.
  *
- * Writes system performance to a file and standard out.
+ * Writes system performance to a file and standard out, and optionally
+ * records it in memory (used by sweeps). The learner only places each report
+ * in a ring buffer; a writer thread formats and writes them, flushing the
+ * files once the ring is empty rather than after every line. Console lines
+ * can be limited to one per PERF_CONSOLE milliseconds (the last one is always
+ * shown), and with PERF_BINARY each report is also written to a compact
+ * binary file of column blocks which xcsconv turns back into text. With
+ * PERF_POP_STATS each report also describes the population's composition.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 #include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "cons.h"
 #include "perf.h"
 #include "cl.h"
 #include "cl_set.h"
+#include "pstat.h"
+
+#define PERF_RING 1024 // reports waiting for the writer
+#define PERF_BLOCK 1024 // rows per binary column block
+#define PERF_WAKE 0.05 // seconds reports may wait before the writer is woken
+
+void perf_columns();
+void perf_start();
+void perf_stop();
+void perf_line(FILE *f, double *r);
+void perf_bin_row(double *r);
+void perf_bin_block();
+void *perf_writer(void *arg);
+double perf_time();
   
 FILE *fout;
-char fname[30];
+FILE *fbin; // binary column blocks (PERF_BINARY)
+char fname[40];
 char basefname[30];
+int pf_cols; // values per report: trial, perf, error, size, mutation rates
+// and population statistics
+char *pf_desc; // name, type and decimals of each column [col*PERF_BIN_DESC]
+double *pf_ring; // reports [head%PERF_RING] written by the learner
+long pf_head;
+long pf_tail; // reports taken by the writer
+_Bool pf_idle; // the writer has flushed everything and waits
+_Bool pf_done; // the writer should finish
+pid_t pf_pid; // process running the writer, 0 = none
+pthread_t pf_thread;
+pthread_mutex_t pf_lock;
+pthread_cond_t pf_more; // reports added
+pthread_cond_t pf_room; // reports taken
+double pf_woken; // time the writer was last woken
+double pf_shown; // time the last console line was shown
+double *pf_held; // last report not shown on the console
+_Bool pf_holding;
+float *pf_block; // binary column block being filled [column*PERF_BLOCK+row]
+double *pf_block_d; // the same for the double precision columns
+int pf_rows;
 
 void gen_outfname()
 {
@@ -54,15 +100,105 @@ void outfile_init(int exp_num)
 		printf("Error opening file: %s. %s.\n", fname, strerror(errno));
 		exit(EXIT_FAILURE);
 	}       
+	if(PERF_BINARY) {
+		sprintf(fname, "%s-%d.bin", basefname, exp_num);
+		fbin = outfile_open_bin(fname);
+	}
+	perf_start();
+}
+
+void outfile_init_island(int exp_num, int island)
+{
+	// output of the islands other than the first
+	sprintf(fname, "%s-%d-%d.dat", basefname, exp_num, island);
+	fout = fopen(fname, "wt");
+	if(fout == 0) {
+		printf("Error opening file: %s. %s.\n", fname, strerror(errno));
+		exit(EXIT_FAILURE);
+	}       
+	if(PERF_BINARY) {
+		sprintf(fname, "%s-%d-%d.bin", basefname, exp_num, island);
+		fbin = outfile_open_bin(fname);
+	}
+	perf_start();
+}
+
+FILE *outfile_open(char *part)
+{
+	// another output file of the run, such as sweep results
+	char name[60];
+	sprintf(name, "%s-%s.dat", basefname, part);
+	FILE *f = fopen(name, "wt");
+	if(f == 0) {
+		printf("Error opening file: %s. %s.\n", name, strerror(errno));
+		exit(EXIT_FAILURE);
+	}       
+	return f;
+}
+
+FILE *outfile_open_bin(char *name)
+{
+	// header: magic, version, columns, then a name, type and precision each
+	FILE *f = fopen(name, "wb");
+	if(f == 0) {
+		printf("Error opening file: %s. %s.\n", name, strerror(errno));
+		exit(EXIT_FAILURE);
+	}       
+	perf_columns();
+	uint32_t head[3] = {PERF_BIN_MAGIC, 1, pf_cols};
+	fwrite(head, sizeof(head), 1, f);
+	fwrite(pf_desc, PERF_BIN_DESC, pf_cols, f);
+	return f;
+}
+
+void perf_columns()
+{
+	// PERF_BIN_NAME bytes of name, the type and the decimals printed
+	int stats = PERF_POP_STATS ? pstat_cols() : 0;
+	pf_cols = 4 + stats;
+#ifdef SELF_ADAPT_MUTATION
+	pf_cols += NUM_MU;
+#endif
+	free(pf_desc);
+	pf_desc = calloc(pf_cols, PERF_BIN_DESC);
+	char *names[4] = {"trial", "perf", "error", "size"};
+	char types[4] = {'i', 'f', 'd', 'i'};
+	char decs[4] = {0, 2, 5, 0};
+	for(int i = 0; i < pf_cols; i++) {
+		char *col = &pf_desc[i*PERF_BIN_DESC];
+		char name[16]; // cut to PERF_BIN_NAME characters below
+		char type = 'f';
+		char dec = 5;
+		if(i < 4) {
+			strcpy(name, names[i]);
+			type = types[i];
+			dec = decs[i];
+		}
+		else if(i < pf_cols - stats)
+			sprintf(name, "mu%d", i-4);
+		else
+			pstat_column(i - (pf_cols - stats), name, &type, &dec);
+		strncpy(col, name, PERF_BIN_NAME);
+		col[PERF_BIN_NAME] = type;
+		col[PERF_BIN_NAME+1] = dec;
+	}
 }
 
 void outfile_close()
 {
+	perf_stop();
 	fclose(fout);
+	fout = NULL;
+	if(fbin != NULL) {
+		fclose(fbin);
+		fbin = NULL;
+	}
 }
  
 void disp_perf(int *performance, double *error, int expl_p)
 {
+	// a full window is written between reports, so summing it is no more
+	// work per trial than keeping rolling sums, and it never drifts
 	double perf = 0.0;
 	double serr = 0.0;
 	for(int i = 0; i < PERF_AVG_TRIALS; i++) {
@@ -71,16 +207,216 @@ void disp_perf(int *performance, double *error, int expl_p)
 	}
 	perf /= (double)PERF_AVG_TRIALS;
 	serr /= (double)PERF_AVG_TRIALS;
-	printf("%d %.2f %.5f %d", expl_p, perf, serr, pop_num);
-	fprintf(fout, "%d %.2f %.5f %d", expl_p, perf, serr, pop_num);
-#ifdef SELF_ADAPT_MUTATION
-	for(int i = 0; i < NUM_MU; i++) {
-		printf(" %.5f", set_avg_mut(&pset, i));
-		fprintf(fout, " %.5f", set_avg_mut(&pset, i));
+	if(perf_rec != NULL && perf_rec_num < perf_rec_cap) {
+		double *r = &perf_rec[perf_rec_num*4];
+		r[0] = expl_p;
+		r[1] = perf;
+		r[2] = serr;
+		r[3] = pop_num;
+		perf_rec_num++;
 	}
+	if(fout == NULL)
+		return;
+	// a forked process (an island) starts its own writer
+	if(pf_pid != getpid())
+		perf_start();
+	pthread_mutex_lock(&pf_lock);
+	while(pf_head - pf_tail == PERF_RING)
+		pthread_cond_wait(&pf_room, &pf_lock);
+	double *r = &pf_ring[(pf_head % PERF_RING) * pf_cols];
+	r[0] = expl_p;
+	r[1] = perf;
+	r[2] = serr;
+	r[3] = pop_num;
+	int i = 4;
+#ifdef SELF_ADAPT_MUTATION
+	for(; i < 4 + NUM_MU; i++)
+		r[i] = set_avg_mut(&pset, i-4);
 #endif
-	printf("\n");
-	fprintf(fout, "\n");
+	if(PERF_POP_STATS)
+		pstat_report(&r[i]);
+	pf_head++;
+	// wake the writer for batches of reports rather than for each one
+	double now = perf_time();
+	if(pf_head - pf_tail >= PERF_RING/2 || now - pf_woken >= PERF_WAKE) {
+		pthread_cond_signal(&pf_more);
+		pf_woken = now;
+	}
+	pthread_mutex_unlock(&pf_lock);
+}  
+
+void perf_drain()
+{
+	// waits until the writer has written and flushed every report
+	if(pf_pid != getpid())
+		return;
+	pthread_mutex_lock(&pf_lock);
+	pthread_cond_signal(&pf_more);
+	while(!pf_idle || pf_tail != pf_head)
+		pthread_cond_wait(&pf_room, &pf_lock);
+	// the writer is waiting, so its partial column block can be written out
+	if(fbin != NULL) {
+		perf_bin_block();
+		fflush(fbin);
+	}
+	pthread_mutex_unlock(&pf_lock);
+}
+
+void perf_start()
+{
+	// a forked copy of the state belongs to a writer in another process
+	perf_columns();
+	if(pf_ring == NULL) {
+		pf_ring = malloc(sizeof(double)*PERF_RING*pf_cols);
+		pf_held = malloc(sizeof(double)*pf_cols);
+		pf_block = malloc(sizeof(float)*PERF_BLOCK*pf_cols);
+		pf_block_d = malloc(sizeof(double)*PERF_BLOCK*pf_cols);
+	}
+	pf_head = 0;
+	pf_tail = 0;
+	pf_idle = false;
+	pf_done = false;
+	pf_holding = false;
+	pf_shown = 0.0;
+	pf_woken = 0.0;
+	pf_rows = 0;
+	pthread_mutex_init(&pf_lock, NULL);
+	pthread_cond_init(&pf_more, NULL);
+	pthread_cond_init(&pf_room, NULL);
+	if(pthread_create(&pf_thread, NULL, perf_writer, NULL) != 0) {
+		printf("Error creating the output thread\n");
+		exit(EXIT_FAILURE);
+	}
+	pf_pid = getpid();
+}
+
+void perf_stop()
+{
+	if(pf_pid != getpid())
+		return;
+	pthread_mutex_lock(&pf_lock);
+	pf_done = true;
+	pthread_cond_signal(&pf_more);
+	pthread_mutex_unlock(&pf_lock);
+	pthread_join(pf_thread, NULL);
+	pthread_mutex_destroy(&pf_lock);
+	pthread_cond_destroy(&pf_more);
+	pthread_cond_destroy(&pf_room);
+	pf_pid = 0;
+}
+
+void *perf_writer(void *arg)
+{
+	(void)arg;
+	_Bool dirty = false;
+	pthread_mutex_lock(&pf_lock);
+	while(true) {
+		if(pf_tail == pf_head) {
+			if(dirty) {
+				// flush once the ring is empty, not after every line
+				pthread_mutex_unlock(&pf_lock);
+				fflush(stdout);
+				fflush(fout);
+				dirty = false;
+				pthread_mutex_lock(&pf_lock);
+				continue;
+			}
+			if(pf_done)
+				break;
+			pf_idle = true;
+			pthread_cond_broadcast(&pf_room);
+			pthread_cond_wait(&pf_more, &pf_lock);
+			pf_idle = false;
+			continue;
+		}
+		// the learner does not reuse a slot until the tail moves on
+		double *r = &pf_ring[(pf_tail % PERF_RING) * pf_cols];
+		pthread_mutex_unlock(&pf_lock);
+		perf_line(fout, r);
+		double now = perf_time();
+		if(now - pf_shown >= PERF_CONSOLE / 1000.0) {
+			perf_line(stdout, r);
+			pf_shown = now;
+			pf_holding = false;
+		}
+		else {
+			memcpy(pf_held, r, sizeof(double)*pf_cols);
+			pf_holding = true;
+		}
+		if(fbin != NULL)
+			perf_bin_row(r);
+		dirty = true;
+		pthread_mutex_lock(&pf_lock);
+		pf_tail++;
+		pthread_cond_broadcast(&pf_room);
+	}
+	pthread_mutex_unlock(&pf_lock);
+	// the last report is always shown
+	if(pf_holding)
+		perf_line(stdout, pf_held);
+	if(fbin != NULL)
+		perf_bin_block();
 	fflush(stdout);
 	fflush(fout);
-}  
+	return NULL;
+}
+
+void perf_line(FILE *f, double *r)
+{
+	for(int i = 0; i < pf_cols; i++) {
+		char *col = &pf_desc[i*PERF_BIN_DESC];
+		if(i > 0)
+			fputc(' ', f);
+		if(col[PERF_BIN_NAME] == 'i')
+			fprintf(f, "%d", (int)r[i]);
+		else
+			fprintf(f, "%.*f", col[PERF_BIN_NAME+1], r[i]);
+	}
+	fputc('\n', f);
+}
+
+void perf_bin_row(double *r)
+{
+	// integers and floats are 4 bytes and 'd' columns 8; a float holds the
+	// value as printed, which it keeps to the decimals of a text line
+	for(int i = 0; i < pf_cols; i++) {
+		char *col = &pf_desc[i*PERF_BIN_DESC];
+		if(col[PERF_BIN_NAME] == 'i') {
+			int32_t v = (int32_t)r[i];
+			memcpy(&pf_block[i*PERF_BLOCK+pf_rows], &v, sizeof(v));
+		}
+		else if(col[PERF_BIN_NAME] == 'd')
+			pf_block_d[i*PERF_BLOCK+pf_rows] = r[i];
+		else {
+			char s[64];
+			snprintf(s, sizeof(s), "%.*f", col[PERF_BIN_NAME+1], r[i]);
+			pf_block[i*PERF_BLOCK+pf_rows] = strtof(s, NULL);
+		}
+	}
+	pf_rows++;
+	if(pf_rows == PERF_BLOCK)
+		perf_bin_block();
+}
+
+void perf_bin_block()
+{
+	// the number of rows, then each column's values in turn
+	if(pf_rows == 0)
+		return;
+	uint32_t rows = pf_rows;
+	fwrite(&rows, sizeof(rows), 1, fbin);
+	for(int i = 0; i < pf_cols; i++) {
+		if(pf_desc[i*PERF_BIN_DESC+PERF_BIN_NAME] == 'd')
+			fwrite(&pf_block_d[i*PERF_BLOCK], sizeof(double), pf_rows, fbin);
+		else
+			fwrite(&pf_block[i*PERF_BLOCK], sizeof(float), pf_rows, fbin);
+	}
+	pf_rows = 0;
+}
+
+double perf_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -15,7 +15,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define PERF_BIN_MAGIC 0x50534358 // "XCSP"
+#define PERF_BIN_NAME 6 // characters of a binary column name
+#define PERF_BIN_DESC (PERF_BIN_NAME+2) // bytes describing a binary column
+
 void disp_perf(int *performance, double *error, int expl_p);
 void gen_outfname();
 void outfile_close();
 void outfile_init(int exp_num);
+void outfile_init_island(int exp_num, int island);
+FILE *outfile_open(char *part);
+FILE *outfile_open_bin(char *name);
+void perf_drain();
+
+double *perf_rec; // if not NULL, disp_perf also records trial, perf, error, size
+int perf_rec_num; // points recorded
+int perf_rec_cap; // points that fit in perf_rec
@@ -53,6 +53,33 @@ double pred_compute(PRED *pred, double *state)
 	(void)state; // remove unused parameter warnings
 	return pred->pre;
 }
+double pred_eval(REAL *w, double *state)
+{
+	(void)state; // remove unused parameter warnings
+	return w[0];
+}
+int pred_coeffs(PRED *pred, REAL *w)
+{
+	if(w != NULL)
+		w[0] = pred->pre;
+	return 1;
+}
+
+size_t pred_save(PRED *pred, char *buf)
+{
+	if(buf != NULL) {
+		memcpy(buf, &pred->pre, sizeof(double));
+		memcpy(buf+sizeof(double), &pred->exp, sizeof(int));
+	}
+	return sizeof(double)+sizeof(int);
+}
+
+size_t pred_load(PRED *pred, char *buf)
+{
+	memcpy(&pred->pre, buf, sizeof(double));
+	memcpy(&pred->exp, buf+sizeof(double), sizeof(int));
+	return sizeof(double)+sizeof(int);
+}
 
 void pred_print(PRED *pred)
 {
@@ -35,6 +35,7 @@
 #include "random.h"
 #include "cons.h"
 #include "cl.h"
+#include "kern.h"
 
 void pred_init(PRED *pred)
 {
@@ -44,7 +45,7 @@ void pred_init(PRED *pred)
 #else
 	pred->weights_length = dstate_length+1;
 #endif
-	pred->weights = malloc(sizeof(double) * pred->weights_length);
+	pred->weights = malloc(sizeof(REAL) * pred->weights_length);
 	pred->weights[0] = XCSF_X0;
 	for(int i = 1; i < pred->weights_length; i++)
 		pred->weights[i] = 0.0;
@@ -64,45 +65,38 @@ void pred_update(PRED *pred, double p, double *state)
 {
 	// pre must have been updated for the current state previously in cl_update
 	double error = p - pred->pre; //pred_compute(pred, state);
-	double norm = XCSF_X0 * XCSF_X0;
-	for(int i = 0; i < dstate_length; i++)
-		norm += state[i] * state[i];
-	double correction = (XCSF_ETA * error) / norm;
-	// update first coefficient
-	pred->weights[0] += XCSF_X0 * correction;
-	int index = 1;
-	// update linear coefficients
-	for(int i = 0; i < dstate_length; i++)
-		pred->weights[index++] += correction * state[i];
-#ifdef QUADRATIC
-	// update quadratic coefficients
-	for(int i = 0; i < dstate_length; i++) {
-		for(int j = i; j < dstate_length; j++) {
-			pred->weights[index++] += correction * state[i] * state[j];
-		}
-	}
-#endif
+	kern_update(pred->weights, state, error);
 }
 
 double pred_compute(PRED *pred, double *state)
 {
-	// first coefficient is offset
-	double pre = XCSF_X0 * pred->weights[0];
-	int index = 1;
-	// multiply linear coefficients with the prediction input
-	for(int i = 0; i < dstate_length; i++)
-		pre += pred->weights[index++] * state[i];
-#ifdef QUADRATIC
-	// multiply quadratic coefficients with prediction input
-	for(int i = 0; i < dstate_length; i++) {
-		for(int j = i; j < dstate_length; j++) {
-			pre += pred->weights[index++] * state[i] * state[j];
-		}
-	}
-#endif
-	pred->pre = pre;
-	return pre;
+	pred->pre = pred_eval(pred->weights, state);
+	return pred->pre;
 } 
+double pred_eval(REAL *w, double *state)
+{
+	return kern_eval(w, state);
+}
+int pred_coeffs(PRED *pred, REAL *w)
+{
+	// copies the coefficients the prediction is computed from (unless NULL)
+	if(w != NULL)
+		memcpy(w, pred->weights, sizeof(REAL)*pred->weights_length);
+	return pred->weights_length;
+}
+
+size_t pred_save(PRED *pred, char *buf)
+{
+	if(buf != NULL)
+		memcpy(buf, pred->weights, sizeof(REAL)*pred->weights_length);
+	return sizeof(REAL)*pred->weights_length;
+}
+
+size_t pred_load(PRED *pred, char *buf)
+{
+	memcpy(pred->weights, buf, sizeof(REAL)*pred->weights_length);
+	return sizeof(REAL)*pred->weights_length;
+}
 
 void pred_print(PRED *pred)
 {
@@ -19,7 +19,7 @@
 
 typedef struct PRED {
 	int weights_length;
-	double *weights;
+	REAL *weights;
 	double pre;
 } PRED;
 
@@ -30,13 +30,13 @@
 #include "random.h"
 #include "cons.h"
 #include "cl.h"
+#include "kern.h"
 
 #define RLS_SCALE_FACTOR 1000.0
 #define RLS_LAMBDA 1.0
 
-void matrix_matrix_multiply(double *srca, double *srcb, double *dest, int n);
-void matrix_vector_multiply(double *srcm, double *srcv, double *dest, int n);
-void init_matrix(double *matrix, int n);
+void matrix_vector_multiply(REAL *srcm, double *srcv, double *dest, int n);
+void init_matrix(REAL *matrix, int n);
 
 void pred_init(PRED *pred)
 {
@@ -46,17 +46,17 @@ void pred_init(PRED *pred)
 #else
 	pred->weights_length = dstate_length+1;
 #endif
-	pred->weights = malloc(sizeof(double)*pred->weights_length);
+	pred->weights = malloc(sizeof(REAL)*pred->weights_length);
 	pred->weights[0] = XCSF_X0;
 	for(int i = 1; i < pred->weights_length; i++)
 		pred->weights[i] = 0.0;
 
 	// initialise gain matrix
-	pred->matrix = malloc(sizeof(double)*pred->weights_length*pred->weights_length);
+	pred->matrix = malloc(sizeof(REAL)*pred->weights_length*pred->weights_length);
 	init_matrix(pred->matrix, pred->weights_length);
 }
  	
-void init_matrix(double *matrix, int n)
+void init_matrix(REAL *matrix, int n)
 {
 	for(int row = 0; row < n; row++) {
 		for(int col = 0; col < n; col++) {
@@ -83,11 +83,8 @@ void pred_free(PRED *pred)
 void pred_update(PRED *pred, double p, double *state)
 {
 	int n = pred->weights_length;
-	int n_sqrd = n*n;
 	double tmp_input[n];
 	double tmp_vec[n];
-	double tmp_matrix1[n_sqrd];
-	double tmp_matrix2[n_sqrd];
 
 	tmp_input[0] = XCSF_X0;
 	int index = 1;
@@ -117,46 +114,44 @@ void pred_update(PRED *pred, double p, double *state)
 	for(int i = 0; i < n; i++)
 		pred->weights[i] += error * tmp_vec[i];
 
-	// update gain matrix
-	for(int i = 0; i < n; i++) {
-		for(int j = 0; j < n; j++) {
-			double tmp = tmp_vec[i] * tmp_input[j];
-			if(i == j)
-				tmp_matrix1[i*n+j] = 1.0 - tmp;
-			else
-				tmp_matrix1[i*n+j] = -tmp;
-		}
-	}
-	matrix_matrix_multiply(tmp_matrix1, pred->matrix, tmp_matrix2, n);
-
-	// divide gain matrix entries by lambda
-	for(int row = 0; row < n; row++) {
-		for(int col = 0; col < n; col++) {
-			pred->matrix[row*n+col] = 
-				tmp_matrix2[row*n+col] / RLS_LAMBDA;
-		}
-	}
+	// update gain matrix and divide its entries by lambda
+	kern_rls(pred->matrix, tmp_vec, tmp_input, RLS_LAMBDA, n);
 }
 
 double pred_compute(PRED *pred, double *state)
 {
-	// first coefficient is offset
-	double pre = XCSF_X0 * pred->weights[0];
-	int index = 1;
-	// multiply linear coefficients with the prediction input
-	for(int i = 0; i < dstate_length; i++)
-		pre += pred->weights[index++] * state[i];
-#ifdef QUADRATIC
-	// multiply quadratic coefficients with prediction input
-	for(int i = 0; i < dstate_length; i++) {
-		for(int j = i; j < dstate_length; j++) {
-			pre += pred->weights[index++] * state[i] * state[j];
-		}
-	}
-#endif
-	pred->pre = pre;
-	return pre;
+	pred->pre = pred_eval(pred->weights, state);
+	return pred->pre;
 } 
+double pred_eval(REAL *w, double *state)
+{
+	return kern_eval(w, state);
+}
+int pred_coeffs(PRED *pred, REAL *w)
+{
+	// copies the coefficients the prediction is computed from (unless NULL)
+	if(w != NULL)
+		memcpy(w, pred->weights, sizeof(REAL)*pred->weights_length);
+	return pred->weights_length;
+}
+
+size_t pred_save(PRED *pred, char *buf)
+{
+	int n = pred->weights_length;
+	if(buf != NULL) {
+		memcpy(buf, pred->weights, sizeof(REAL)*n);
+		memcpy(buf+sizeof(REAL)*n, pred->matrix, sizeof(REAL)*n*n);
+	}
+	return sizeof(REAL)*(n+n*n);
+}
+
+size_t pred_load(PRED *pred, char *buf)
+{
+	int n = pred->weights_length;
+	memcpy(pred->weights, buf, sizeof(REAL)*n);
+	memcpy(pred->matrix, buf+sizeof(REAL)*n, sizeof(REAL)*n*n);
+	return sizeof(REAL)*(n+n*n);
+}
 
 void pred_print(PRED *pred)
 {
@@ -172,19 +167,7 @@ void pred_print(PRED *pred)
 //	printf("\n");
 }
 
-void matrix_matrix_multiply(double *srca, double *srcb, double *dest, int n)
-{
-	for(int i = 0; i < n; i++) {
-		for(int j = 0; j < n; j++) {
-			dest[i*n+j] = srca[i*n] * srcb[j];
-			for(int k = 1; k < n; k++) {
-				dest[i*n+j] += srca[i*n+k] * srcb[k*n+j];
-			}
-		}
-	}
-}
-
-void matrix_vector_multiply(double *srcm, double *srcv, double *dest, int n)
+void matrix_vector_multiply(REAL *srcm, double *srcv, double *dest, int n)
 {
 	for(int i = 0; i < n; i++) {
 		dest[i] = srcm[i*n] * srcv[0];
@@ -19,8 +19,8 @@
 
 typedef struct PRED {
 	int weights_length;
-	double *weights;
-	double *matrix;
+	REAL *weights;
+	REAL *matrix;
 	double pre;
 } PRED;
 
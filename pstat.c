@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The population statistics module.
+ *
+ * Keeps the population's numerosity by action and by condition generality,
+ * and its summed specificity, as micro-classifiers enter and leave it, so
+ * reporting them costs nothing. Experience and fitness change at every
+ * update and are instead summed over the population each time a performance
+ * report asks for them, once every PERF_AVG_TRIALS trials.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "cond_interval.h"
+#include "pstat.h"
+
+int pstat_bin(double x);
+
+double ps_spec; // numerosity weighted sum of condition specificity
+int ps_gen[PSTAT_BINS]; // numerosity by condition generality
+int *ps_act; // numerosity advocating each action
+
+void pstat_init()
+{
+	ps_spec = 0.0;
+	for(int i = 0; i < PSTAT_BINS; i++)
+		ps_gen[i] = 0;
+	ps_act = calloc(num_actions, sizeof(int));
+}
+
+void pstat_free()
+{
+	free(ps_act);
+	ps_act = NULL;
+}
+
+void pstat_num(CL *c, int n)
+{
+	// n micro-classifiers of c have entered the population, or left it if
+	// n is negative; a classifier's condition and action do not change
+	// while it is a member
+	if(!PERF_POP_STATS)
+		return;
+	double spec = pstat_spec(c);
+	ps_spec += spec * n;
+	ps_gen[pstat_bin(1.0 - spec)] += n;
+	ps_act[c->act.a] += n;
+}
+
+double pstat_spec(CL *c)
+{
+	// fraction of the input space the condition constrains
+	if(COND_TYPE == 1)
+		return ivl_spec(&c->cond);
+	return (double)c->cond.spec / state_length;
+}
+
+int pstat_bin(double x)
+{
+	int b = (int)(x * PSTAT_BINS);
+	if(b < 0)
+		return 0;
+	if(b >= PSTAT_BINS)
+		return PSTAT_BINS-1;
+	return b;
+}
+
+int pstat_cols()
+{
+	// micro-classifiers, specificity, generality histogram, numerosity per
+	// action, experience, fitness and fitness histogram
+	return 2 + PSTAT_BINS + num_actions + 2 + PSTAT_BINS;
+}
+
+void pstat_column(int i, char *name, char *type, char *dec)
+{
+	// the name, type ('i', 'f' or 'd') and printed decimals of column i
+	*type = 'i';
+	*dec = 0;
+	if(i == 0)
+		sprintf(name, "micro");
+	else if(i == 1) {
+		sprintf(name, "spec");
+		*type = 'f';
+		*dec = 5;
+	}
+	else if((i -= 2) < PSTAT_BINS)
+		sprintf(name, "gen%d", i);
+	else if((i -= PSTAT_BINS) < num_actions)
+		sprintf(name, "act%d", i);
+	else if((i -= num_actions) == 0) {
+		// a float keeps too few digits once experience grows large
+		sprintf(name, "exp");
+		*type = 'd';
+		*dec = 2;
+	}
+	else if(i == 1) {
+		sprintf(name, "fit");
+		*type = 'f';
+		*dec = 5;
+	}
+	else
+		sprintf(name, "fit%d", i-2);
+}
+
+void pstat_report(double *r)
+{
+	r[0] = pop_num_sum;
+	r[1] = (pop_num_sum > 0) ? ps_spec / pop_num_sum : 0.0;
+	r += 2;
+	for(int i = 0; i < PSTAT_BINS; i++)
+		r[i] = ps_gen[i];
+	r += PSTAT_BINS;
+	for(int i = 0; i < num_actions; i++)
+		r[i] = ps_act[i];
+	r += num_actions;
+	// means per micro-classifier, whose fitness is its classifier's divided
+	// by the numerosity; the histogram is of fitness relative to the fittest
+	double exp = 0.0;
+	double fit = 0.0;
+	double max = 0.0;
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		CL *c = iter->cl;
+		exp += (double)c->exp * c->num;
+		fit += c->fit;
+		if(c->fit / c->num > max)
+			max = c->fit / c->num;
+	}
+	int hist[PSTAT_BINS] = {0};
+	if(max > 0.0) {
+		for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+			CL *c = iter->cl;
+			hist[pstat_bin(c->fit / c->num / max)] += c->num;
+		}
+	}
+	r[0] = (pop_num_sum > 0) ? exp / pop_num_sum : 0.0;
+	r[1] = (pop_num_sum > 0) ? fit / pop_num_sum : 0.0;
+	for(int i = 0; i < PSTAT_BINS; i++)
+		r[2+i] = hist[i];
+}
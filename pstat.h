@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define PSTAT_BINS 5 // buckets of the generality and fitness histograms
+
+double pstat_spec(CL *c);
+int pstat_cols();
+void pstat_column(int i, char *name, char *type, char *dec);
+void pstat_free();
+void pstat_init();
+void pstat_num(CL *c, int n);
+void pstat_report(double *r);
@@ -41,6 +41,11 @@ void random_init()
 	init_genrand64(seed);
 }
 
+void random_seed(unsigned long seed)
+{
+	init_genrand64(seed);
+}
+
 // not inclusive of max
 int irand(int min, int max)
 {
@@ -15,5 +15,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 void random_init();
+void random_seed(unsigned long seed);
 double drand();
 int irand( int min, int max );
@@ -37,14 +37,14 @@ double gasdev();
 
 void sam_init(CL *c)
 {
-	c->mu = malloc(sizeof(double)*NUM_MU);
+	c->mu = malloc(sizeof(REAL)*NUM_MU);
 	for(int i = 0; i < NUM_MU; i++)
 		c->mu[i] = drand();
 }
 
 void sam_copy(CL *to, CL *from)
 {
-	memcpy(to->mu, from->mu, sizeof(double)*NUM_MU);
+	memcpy(to->mu, from->mu, sizeof(REAL)*NUM_MU);
 }
 
 void sam_free(CL *c)
@@ -52,6 +52,19 @@ void sam_free(CL *c)
 	free(c->mu);
 }
 
+size_t sam_save(CL *c, char *buf)
+{
+	if(buf != NULL)
+		memcpy(buf, c->mu, sizeof(REAL)*NUM_MU);
+	return sizeof(REAL)*NUM_MU;
+}
+
+size_t sam_load(CL *c, char *buf)
+{
+	memcpy(c->mu, buf, sizeof(REAL)*NUM_MU);
+	return sizeof(REAL)*NUM_MU;
+}
+
 void sam_adapt(CL *c)
 {
 	for(int i = 0; i < NUM_MU; i++) {
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The serving daemon.
+ *
+ * Answers queries from a population that keeps learning. Requests are read a
+ * line at a time from standard input, or from each client of a UNIX domain
+ * socket if a path is given:
+ *
+ *   <state>                    replies "<action> <prediction> <epoch>"
+ *   <state> <action> <reward>  queues the reward received for an action
+ *   stats                      replies with the latency and throughput so far
+ *
+ * Queries are answered from the most recently published snapshot of the
+ * population and never wait for the learner thread, which trains on the
+ * queued rewards and publishes every SERVE_PUBLISH updates. Rewards arriving
+ * while SERVE_QUEUE are waiting are dropped. A random action with prediction
+ * 0 is served when no published classifier matches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "cons.h"
+#include "random.h"
+#include "xcs.h"
+#include "kern.h"
+
+#define SERVE_SAMPLES 16384 // most recent latencies kept per reader
+
+typedef struct REWARD {
+	char *state;
+	int action;
+	double reward;
+} REWARD;
+
+typedef struct READER {
+	pthread_mutex_t lock;
+	double *lat; // latencies of the most recent queries (seconds)
+	long num; // queries answered
+	_Bool used;
+	int fd; // client socket (-1 = standard input)
+} READER;
+
+double serve_time();
+int serve_cmp(const void *a, const void *b);
+int serve_reader_get(int fd);
+void *serve_client(void *arg);
+void *serve_learner(void *arg);
+void serve_quit(int sig);
+void serve_reader_put(int reader);
+void serve_reward(char *state, int action, double reward);
+void serve_socket(char *path);
+void serve_stats(FILE *out);
+void serve_stream(FILE *in, FILE *out, int reader);
+
+XCS *sv_xcs;
+pthread_mutex_t sv_lock;
+pthread_cond_t sv_ready; // a reward was queued or the learner must stop
+pthread_cond_t sv_idle; // a reader was released
+REWARD *sv_queue; // rewards waiting for the learner (circular)
+int sv_head;
+int sv_num;
+long sv_dropped;
+long sv_updates;
+_Bool sv_done;
+READER *sv_readers;
+double sv_start;
+volatile sig_atomic_t sv_quit;
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3 || argc > 4) {
+		printf("Usage: xcsd stateLength numActions [socket]\n");
+		exit(EXIT_FAILURE);
+	}
+	XCS_PARAMS p;
+	constants_init(1, argv, &p);
+	random_init();
+	p.state_length = atoi(argv[1]);
+	p.num_actions = atoi(argv[2]);
+	sv_xcs = xcs_create(&p);
+	if(sv_xcs == NULL) {
+		printf("Error creating the learner\n");
+		exit(EXIT_FAILURE);
+	}
+	printf("kernels: %s\n", kern_name());
+	xcs_publish(sv_xcs);
+
+	// start the learner
+	pthread_mutex_init(&sv_lock, NULL);
+	pthread_cond_init(&sv_ready, NULL);
+	pthread_cond_init(&sv_idle, NULL);
+	sv_queue = malloc(sizeof(REWARD)*SERVE_QUEUE);
+	for(int i = 0; i < SERVE_QUEUE; i++)
+		sv_queue[i].state = malloc(sizeof(char)*state_length);
+	sv_head = 0;
+	sv_num = 0;
+	sv_dropped = 0;
+	sv_updates = 0;
+	sv_done = false;
+	sv_readers = malloc(sizeof(READER)*SERVE_READERS);
+	for(int i = 0; i < SERVE_READERS; i++) {
+		pthread_mutex_init(&sv_readers[i].lock, NULL);
+		sv_readers[i].lat = malloc(sizeof(double)*SERVE_SAMPLES);
+		sv_readers[i].num = 0;
+		sv_readers[i].used = false;
+	}
+	sv_quit = 0;
+	signal(SIGPIPE, SIG_IGN);
+	sigset_t sigs, old;
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, &old);
+	pthread_t learner;
+	pthread_create(&learner, NULL, serve_learner, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	sv_start = serve_time();
+
+	// serve
+	if(argc == 4)
+		serve_socket(argv[3]);
+	else
+		serve_stream(stdin, stdout, serve_reader_get(-1));
+
+	// stop the learner once it has caught up
+	pthread_mutex_lock(&sv_lock);
+	sv_done = true;
+	pthread_cond_signal(&sv_ready);
+	pthread_mutex_unlock(&sv_lock);
+	pthread_join(learner, NULL);
+	serve_stats(stderr);
+
+	// clean up
+	xcs_destroy(sv_xcs);
+	for(int i = 0; i < SERVE_QUEUE; i++)
+		free(sv_queue[i].state);
+	free(sv_queue);
+	for(int i = 0; i < SERVE_READERS; i++) {
+		pthread_mutex_destroy(&sv_readers[i].lock);
+		free(sv_readers[i].lat);
+	}
+	free(sv_readers);
+	pthread_mutex_destroy(&sv_lock);
+	pthread_cond_destroy(&sv_ready);
+	pthread_cond_destroy(&sv_idle);
+	return EXIT_SUCCESS;
+}
+
+void serve_stream(FILE *in, FILE *out, int reader)
+{
+	// answers the requests on one stream until it is closed
+	READER *rd = &sv_readers[reader];
+	unsigned int seed = reader + 1;
+	char *line = NULL;
+	size_t cap = 0;
+	ssize_t len;
+	while((len = getline(&line, &cap, in)) > 0) {
+		double start = serve_time();
+		while(len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+			line[--len] = '\0';
+		if(len == 0)
+			continue;
+		if(strcmp(line, "stats") == 0) {
+			serve_stats(out);
+			fflush(out);
+			continue;
+		}
+		int action;
+		double reward;
+		if(len < state_length || strspn(line, "01") != (size_t)state_length) {
+			fprintf(out, "error\n");
+			fflush(out);
+		}
+		else if(line[state_length] == '\0') {
+			double payoff;
+			long epoch;
+			action = xcs_serve_action(reader, line, NULL, &payoff, &epoch);
+			if(action < 0)
+				action = rand_r(&seed) % num_actions;
+			fprintf(out, "%d %f %ld\n", action, payoff, epoch);
+			fflush(out);
+			pthread_mutex_lock(&rd->lock);
+			rd->lat[rd->num % SERVE_SAMPLES] = serve_time() - start;
+			rd->num++;
+			pthread_mutex_unlock(&rd->lock);
+		}
+		else if(sscanf(line+state_length, "%d %lf", &action, &reward) == 2 
+				&& action >= 0 && action < num_actions)
+			serve_reward(line, action, reward);
+		else {
+			fprintf(out, "error\n");
+			fflush(out);
+		}
+	}
+	free(line);
+}
+
+void serve_reward(char *state, int action, double reward)
+{
+	pthread_mutex_lock(&sv_lock);
+	if(sv_num == SERVE_QUEUE)
+		sv_dropped++;
+	else {
+		REWARD *r = &sv_queue[(sv_head + sv_num) % SERVE_QUEUE];
+		memcpy(r->state, state, state_length);
+		r->action = action;
+		r->reward = reward;
+		sv_num++;
+		pthread_cond_signal(&sv_ready);
+	}
+	pthread_mutex_unlock(&sv_lock);
+}
+
+void *serve_learner(void *arg)
+{
+	// the only thread to change the population
+	(void)arg;
+	char state[state_length];
+	long updates = 0;
+	pthread_mutex_lock(&sv_lock);
+	while(true) {
+		while(sv_num == 0 && !sv_done)
+			pthread_cond_wait(&sv_ready, &sv_lock);
+		if(sv_num == 0)
+			break;
+		REWARD *r = &sv_queue[sv_head];
+		memcpy(state, r->state, state_length);
+		int action = r->action;
+		double reward = r->reward;
+		sv_head = (sv_head + 1) % SERVE_QUEUE;
+		sv_num--;
+		pthread_mutex_unlock(&sv_lock);
+		xcs_update(sv_xcs, state, NULL, action, reward);
+		updates++;
+		if(updates % SERVE_PUBLISH == 0)
+			xcs_publish(sv_xcs);
+		pthread_mutex_lock(&sv_lock);
+		sv_updates = updates;
+	}
+	pthread_mutex_unlock(&sv_lock);
+	if(updates % SERVE_PUBLISH != 0)
+		xcs_publish(sv_xcs);
+	return NULL;
+}
+
+void serve_socket(char *path)
+{
+	// one thread per client, each with its own reader slot
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path)-1);
+	unlink(path);
+	if(fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 
+			|| listen(fd, SERVE_READERS) < 0) {
+		perror("Error opening the socket");
+		exit(EXIT_FAILURE);
+	}
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = serve_quit;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	while(!sv_quit) {
+		int c = accept(fd, NULL, NULL);
+		if(c < 0)
+			continue;
+		int reader = serve_reader_get(c);
+		if(reader < 0) {
+			close(c);
+			continue;
+		}
+		sigset_t sigs, old;
+		sigemptyset(&sigs);
+		sigaddset(&sigs, SIGINT);
+		sigaddset(&sigs, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &sigs, &old);
+		pthread_t thread;
+		if(pthread_create(&thread, NULL, serve_client, &sv_readers[reader]) == 0)
+			pthread_detach(thread);
+		else
+			serve_reader_put(reader);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+	}
+	close(fd);
+	unlink(path);
+	// disconnect the clients and wait for their threads
+	pthread_mutex_lock(&sv_lock);
+	for(int i = 0; i < SERVE_READERS; i++) {
+		if(sv_readers[i].used)
+			shutdown(sv_readers[i].fd, SHUT_RDWR);
+	}
+	for(int i = 0; i < SERVE_READERS; i++) {
+		while(sv_readers[i].used)
+			pthread_cond_wait(&sv_idle, &sv_lock);
+	}
+	pthread_mutex_unlock(&sv_lock);
+}
+
+void *serve_client(void *arg)
+{
+	READER *rd = arg;
+	int reader = rd - sv_readers;
+	FILE *in = fdopen(rd->fd, "r");
+	FILE *out = fdopen(dup(rd->fd), "w");
+	if(in != NULL && out != NULL)
+		serve_stream(in, out, reader);
+	if(in != NULL)
+		fclose(in);
+	else
+		close(rd->fd);
+	if(out != NULL)
+		fclose(out);
+	serve_reader_put(reader);
+	return NULL;
+}
+
+int serve_reader_get(int fd)
+{
+	// claims a free reader slot, or returns -1 if all are in use
+	int reader = -1;
+	pthread_mutex_lock(&sv_lock);
+	for(int i = 0; i < SERVE_READERS; i++) {
+		if(!sv_readers[i].used) {
+			sv_readers[i].used = true;
+			sv_readers[i].fd = fd;
+			reader = i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&sv_lock);
+	return reader;
+}
+
+void serve_reader_put(int reader)
+{
+	pthread_mutex_lock(&sv_lock);
+	sv_readers[reader].used = false;
+	pthread_cond_broadcast(&sv_idle);
+	pthread_mutex_unlock(&sv_lock);
+}
+
+void serve_stats(FILE *out)
+{
+	// percentiles over the most recent queries of every reader
+	double *lat = malloc(sizeof(double)*SERVE_SAMPLES*SERVE_READERS);
+	long total = 0;
+	int n = 0;
+	for(int i = 0; i < SERVE_READERS; i++) {
+		READER *rd = &sv_readers[i];
+		pthread_mutex_lock(&rd->lock);
+		int k = (rd->num < SERVE_SAMPLES) ? rd->num : SERVE_SAMPLES;
+		memcpy(&lat[n], rd->lat, sizeof(double)*k);
+		n += k;
+		total += rd->num;
+		pthread_mutex_unlock(&rd->lock);
+	}
+	qsort(lat, n, sizeof(double), serve_cmp);
+	double p50 = (n > 0) ? lat[(int)(0.50*(n-1))] : 0.0;
+	double p99 = (n > 0) ? lat[(int)(0.99*(n-1))] : 0.0;
+	free(lat);
+	pthread_mutex_lock(&sv_lock);
+	long updates = sv_updates;
+	long dropped = sv_dropped;
+	pthread_mutex_unlock(&sv_lock);
+	double secs = serve_time() - sv_start;
+	fprintf(out, "queries %ld p50 %.2fus p99 %.2fus throughput %.0f/s "
+			"updates %ld dropped %ld\n", total, 1e6*p50, 1e6*p99, 
+			(secs > 0.0) ? total / secs : 0.0, updates, dropped);
+}
+
+int serve_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+double serve_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void serve_quit(int sig)
+{
+	(void)sig;
+	sv_quit = 1;
+}
@@ -0,0 +1,482 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The spatial index module for interval conditions.
+ *
+ * Indexes the hyperrectangles of the population's interval conditions so
+ * that a state is only tested against the classifiers whose boxes are near
+ * it. With few inputs the input space [-1,1]^n is divided into a uniform grid
+ * and each box is listed in every cell it overlaps; a point is tested against
+ * its cell's list. With more inputs the boxes are bulk loaded into an R-tree
+ * by sort-tile-recursive packing; classifiers added since are scanned from a
+ * pending list until scanning them has cost about as much as a rebuild, or
+ * enough indexed ones are deleted, and the tree is then rebuilt. Index
+ * entries carry their slot's generation so that deletion is a counter
+ * increment and stale entries are skipped, and dropped from grid cells when
+ * next visited. Conditions are not changed in the population, as mutation
+ * and crossover work on offspring, so maintenance follows only insertion
+ * and deletion.
+ *
+ * Besides matching, containment queries find the classifiers whose boxes
+ * contain a given box, i.e., possible duplicates and subsumers. In automatic
+ * mode a query is periodically made to count the entries the index tests,
+ * which is weighed against the size of the population that the vectorised
+ * scan of the imatch module would test, and the cheaper one is used. Both
+ * give the match set in scan order, so the choice does not change the run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "cond_interval.h"
+#include "imatch.h"
+#include "sindex.h"
+
+#define SINDEX_GRID_DIMS 3 // most inputs indexed by a grid rather than a tree
+#define SINDEX_CELLS 512 // grid cells in total
+#define SINDEX_FANOUT 16 // entries per R-tree node
+#define SINDEX_PERIOD 1000 // calls between costing the index against a scan
+#define SINDEX_SCAN 8 // classifiers scanned in the time an index entry is tested
+#define SINDEX_REBUILD 4 // pending entries scanned per tree entry before a rebuild
+
+typedef struct ENTRY {
+	int id; // population slot
+	unsigned gen; // generation of the slot when indexed
+} ENTRY;
+
+typedef struct CELL {
+	ENTRY *e;
+	int num;
+	int cap;
+} CELL;
+
+_Bool sindex_contains(float *lo1, float *hi1, float *lo2, float *hi2);
+_Bool sindex_live(ENTRY e);
+int sindex_cell(float x);
+int sindex_cmp(const void *a, const void *b);
+void sindex_build();
+void sindex_cell_add(CELL *cell, ENTRY e);
+void sindex_contain(NODE **set, COND *cond);
+void sindex_grow(int id);
+void sindex_refresh();
+void sindex_tile(int *ids, int n, int dim);
+
+CL **si_cl; // classifier in each slot
+unsigned *si_gen; // generation of each slot, advanced when it is freed
+int si_cap;
+_Bool si_grid; // whether a grid rather than a tree is used
+int si_side; // grid cells per input
+CELL *si_cells;
+// R-tree nodes: entries, whether they are slots, their bounds and references
+int *si_rnum;
+_Bool *si_rleaf;
+ENTRY *si_rref;
+float *si_rlo;
+float *si_rhi;
+int si_rnodes;
+int si_root; // -1 when empty
+int si_built; // classifiers in the tree when it was built
+int si_stale; // of which since deleted
+int *si_pend; // slots added since the tree was built
+int *si_pend_pos; // position of each slot in si_pend, or -1
+int si_pend_num;
+long si_pend_work; // pending entries scanned since the tree was built
+float *si_key; // sort key per slot while building
+int si_calls;
+long si_tested; // index entries tested by queries
+_Bool si_faster;
+
+void sindex_init()
+{
+	si_cl = NULL;
+	si_gen = NULL;
+	si_pend_pos = NULL;
+	si_cap = 0;
+	si_grid = (dstate_length <= SINDEX_GRID_DIMS);
+	si_cells = NULL;
+	if(si_grid) {
+		si_side = (int)pow(SINDEX_CELLS, 1.0 / dstate_length);
+		int cells = (int)pow(si_side, dstate_length);
+		si_cells = calloc(cells, sizeof(CELL));
+	}
+	si_rnum = NULL;
+	si_rleaf = NULL;
+	si_rref = NULL;
+	si_rlo = NULL;
+	si_rhi = NULL;
+	si_rnodes = 0;
+	si_root = -1;
+	si_built = 0;
+	si_stale = 0;
+	si_pend = NULL;
+	si_pend_num = 0;
+	si_pend_work = 0;
+	si_key = NULL;
+	si_calls = 0;
+	si_tested = 0;
+	si_faster = false;
+}
+
+void sindex_free()
+{
+	if(si_grid) {
+		int cells = (int)pow(si_side, dstate_length);
+		for(int i = 0; i < cells; i++)
+			free(si_cells[i].e);
+		free(si_cells);
+	}
+	free(si_rnum);
+	free(si_rleaf);
+	free(si_rref);
+	free(si_rlo);
+	free(si_rhi);
+	free(si_pend);
+	free(si_pend_pos);
+	free(si_key);
+	free(si_cl);
+	free(si_gen);
+}
+
+void sindex_grow(int id)
+{
+	int cap = si_cap;
+	while(cap <= id)
+		cap = (cap == 0) ? 1024 : cap * 2;
+	si_cl = realloc(si_cl, sizeof(CL*)*cap);
+	si_gen = realloc(si_gen, sizeof(unsigned)*cap);
+	si_pend = realloc(si_pend, sizeof(int)*cap);
+	si_pend_pos = realloc(si_pend_pos, sizeof(int)*cap);
+	for(int i = si_cap; i < cap; i++) {
+		si_cl[i] = NULL;
+		si_gen[i] = 0;
+		si_pend_pos[i] = -1;
+	}
+	si_cap = cap;
+}
+
+_Bool sindex_live(ENTRY e)
+{
+	return si_gen[e.id] == e.gen && si_cl[e.id] != NULL;
+}
+
+int sindex_cell(float x)
+{
+	// grid column of a value; values outside [-1,1] fall in the edge cells
+	int i = (int)((x + 1.0f) * 0.5f * si_side);
+	if(i < 0)
+		return 0;
+	if(i >= si_side)
+		return si_side - 1;
+	return i;
+}
+
+void sindex_cell_add(CELL *cell, ENTRY e)
+{
+	if(cell->num == cell->cap) {
+		// drop stale entries before growing
+		int j = 0;
+		for(int i = 0; i < cell->num; i++) {
+			if(sindex_live(cell->e[i]))
+				cell->e[j++] = cell->e[i];
+		}
+		cell->num = j;
+		if(cell->num >= cell->cap / 2) {
+			cell->cap = (cell->cap == 0) ? 8 : cell->cap * 2;
+			cell->e = realloc(cell->e, sizeof(ENTRY)*cell->cap);
+		}
+	}
+	cell->e[cell->num++] = e;
+}
+
+void sindex_add(CL *c)
+{
+	if(c->id >= si_cap)
+		sindex_grow(c->id);
+	si_cl[c->id] = c;
+	ENTRY e = {c->id, si_gen[c->id]};
+	if(!si_grid) {
+		si_pend_pos[c->id] = si_pend_num;
+		si_pend[si_pend_num++] = c->id;
+		return;
+	}
+	// list the classifier in each cell its box overlaps
+	int from[dstate_length], to[dstate_length], at[dstate_length];
+	for(int i = 0; i < dstate_length; i++) {
+		from[i] = sindex_cell(c->cond.lo[i]);
+		to[i] = sindex_cell(c->cond.hi[i]);
+		at[i] = from[i];
+	}
+	while(true) {
+		int cell = 0;
+		for(int i = dstate_length - 1; i >= 0; i--)
+			cell = cell * si_side + at[i];
+		sindex_cell_add(&si_cells[cell], e);
+		int i = 0;
+		while(i < dstate_length && at[i] == to[i]) {
+			at[i] = from[i];
+			i++;
+		}
+		if(i == dstate_length)
+			break;
+		at[i]++;
+	}
+}
+
+void sindex_del(CL *c)
+{
+	si_cl[c->id] = NULL;
+	si_gen[c->id]++;
+	if(si_grid)
+		return;
+	int p = si_pend_pos[c->id];
+	if(p >= 0) {
+		si_pend_num--;
+		si_pend[p] = si_pend[si_pend_num];
+		si_pend_pos[si_pend[p]] = p;
+		si_pend_pos[c->id] = -1;
+	}
+	else
+		si_stale++;
+}
+
+void sindex_refresh()
+{
+	// rebuilds the tree once scanning the pending list has cost about as
+	// much as building, or a quarter of the tree's entries are deleted
+	if(si_grid)
+		return;
+	long limit = SINDEX_FANOUT + si_built;
+	if(si_pend_work > limit * SINDEX_REBUILD || si_stale > limit / 4)
+		sindex_build();
+	si_pend_work += si_pend_num;
+}
+
+int sindex_cmp(const void *a, const void *b)
+{
+	float ka = si_key[*(const int *)a];
+	float kb = si_key[*(const int *)b];
+	return (ka > kb) - (ka < kb);
+}
+
+void sindex_tile(int *ids, int n, int dim)
+{
+	// sort-tile-recursive: sort by the box centres along dim, cut into
+	// slabs and sort each slab along the next input
+	for(int i = 0; i < n; i++) {
+		CL *c = si_cl[ids[i]];
+		si_key[ids[i]] = c->cond.lo[dim] + c->cond.hi[dim];
+	}
+	qsort(ids, n, sizeof(int), sindex_cmp);
+	int k = dstate_length - dim;
+	if(k == 1 || n <= SINDEX_FANOUT)
+		return;
+	int leaves = (n + SINDEX_FANOUT - 1) / SINDEX_FANOUT;
+	int slabs = (int)ceil(pow(leaves, 1.0 / k));
+	int slab = SINDEX_FANOUT * ((leaves + slabs - 1) / slabs);
+	for(int s = 0; s < n; s += slab)
+		sindex_tile(&ids[s], (n - s < slab) ? n - s : slab, dim + 1);
+}
+
+void sindex_build()
+{
+	// bulk loads every live classifier into a new tree
+	int n = 0;
+	for(int i = 0; i < si_cap; i++) {
+		if(si_cl[i] != NULL)
+			si_pend[n++] = i;
+		si_pend_pos[i] = -1;
+	}
+	si_pend_num = 0;
+	si_pend_work = 0;
+	si_built = n;
+	si_stale = 0;
+	si_root = -1;
+	si_rnodes = 0;
+	if(n == 0)
+		return;
+	si_key = realloc(si_key, sizeof(float)*si_cap);
+	sindex_tile(si_pend, n, 0);
+	int nodes = 0;
+	for(int m = n; m > 1; m = (m + SINDEX_FANOUT - 1) / SINDEX_FANOUT)
+		nodes += (m + SINDEX_FANOUT - 1) / SINDEX_FANOUT;
+	if(nodes == 0)
+		nodes = 1;
+	int w = SINDEX_FANOUT * dstate_length;
+	si_rnum = realloc(si_rnum, sizeof(int)*nodes);
+	si_rleaf = realloc(si_rleaf, sizeof(_Bool)*nodes);
+	si_rref = realloc(si_rref, sizeof(ENTRY)*nodes*SINDEX_FANOUT);
+	si_rlo = realloc(si_rlo, sizeof(float)*nodes*w);
+	si_rhi = realloc(si_rhi, sizeof(float)*nodes*w);
+	// leaves hold the slots in tiled order
+	for(int i = 0; i < n; i++) {
+		int node = i / SINDEX_FANOUT, k = i % SINDEX_FANOUT;
+		CL *c = si_cl[si_pend[i]];
+		si_rref[node*SINDEX_FANOUT+k] = (ENTRY){si_pend[i], si_gen[si_pend[i]]};
+		memcpy(&si_rlo[node*w+k*dstate_length], c->cond.lo, sizeof(float)*dstate_length);
+		memcpy(&si_rhi[node*w+k*dstate_length], c->cond.hi, sizeof(float)*dstate_length);
+		si_rnum[node] = k + 1;
+		si_rleaf[node] = true;
+	}
+	// each level above bounds consecutive runs of the level below
+	int first = 0, num = (n + SINDEX_FANOUT - 1) / SINDEX_FANOUT;
+	si_rnodes = num;
+	while(num > 1) {
+		for(int i = 0; i < num; i++) {
+			int child = first + i;
+			int node = si_rnodes + i / SINDEX_FANOUT, k = i % SINDEX_FANOUT;
+			float *lo = &si_rlo[node*w+k*dstate_length];
+			float *hi = &si_rhi[node*w+k*dstate_length];
+			for(int d = 0; d < dstate_length; d++) {
+				lo[d] = INFINITY;
+				hi[d] = -INFINITY;
+				for(int j = 0; j < si_rnum[child]; j++) {
+					lo[d] = fminf(lo[d], si_rlo[child*w+j*dstate_length+d]);
+					hi[d] = fmaxf(hi[d], si_rhi[child*w+j*dstate_length+d]);
+				}
+			}
+			si_rref[node*SINDEX_FANOUT+k] = (ENTRY){child, 0};
+			si_rnum[node] = k + 1;
+			si_rleaf[node] = false;
+		}
+		first = si_rnodes;
+		si_rnodes += (num + SINDEX_FANOUT - 1) / SINDEX_FANOUT;
+		num = si_rnodes - first;
+	}
+	si_root = first;
+}
+
+_Bool sindex_contains(float *lo1, float *hi1, float *lo2, float *hi2)
+{
+	// whether box 1 contains box 2; a point is a box with equal bounds
+	for(int i = 0; i < dstate_length; i++) {
+		if(lo1[i] > lo2[i] || hi1[i] < hi2[i])
+			return false;
+	}
+	return true;
+}
+
+void sindex_match(NODE **mset, double *dstate)
+{
+	// adds the classifiers whose boxes contain the state
+	float x[dstate_length];
+	for(int i = 0; i < dstate_length; i++)
+		x[i] = (float)dstate[i];
+	COND point = {.lo = x, .hi = x};
+	sindex_contain(mset, &point);
+	set_order(mset);
+}
+
+void sindex_contain(NODE **set, COND *cond)
+{
+	// adds the classifiers whose boxes contain the box of cond
+	if(si_grid) {
+		// such a box overlaps the cell of cond's lower corner
+		int cell = 0;
+		for(int i = dstate_length - 1; i >= 0; i--)
+			cell = cell * si_side + sindex_cell(cond->lo[i]);
+		CELL *cl = &si_cells[cell];
+		si_tested += cl->num;
+		int j = 0;
+		for(int i = 0; i < cl->num; i++) {
+			if(!sindex_live(cl->e[i]))
+				continue;
+			cl->e[j++] = cl->e[i];
+			CL *c = si_cl[cl->e[i].id];
+			if(sindex_contains(c->cond.lo, c->cond.hi, cond->lo, cond->hi))
+				set_add(set, c);
+		}
+		cl->num = j;
+		return;
+	}
+	sindex_refresh();
+	si_tested += si_pend_num;
+	for(int i = 0; i < si_pend_num; i++) {
+		CL *c = si_cl[si_pend[i]];
+		if(sindex_contains(c->cond.lo, c->cond.hi, cond->lo, cond->hi))
+			set_add(set, c);
+	}
+	if(si_root < 0)
+		return;
+	int w = SINDEX_FANOUT * dstate_length;
+	int stack[64 * SINDEX_FANOUT];
+	int top = 0;
+	stack[top++] = si_root;
+	while(top > 0) {
+		int node = stack[--top];
+		si_tested += si_rnum[node];
+		for(int k = 0; k < si_rnum[node]; k++) {
+			float *lo = &si_rlo[node*w+k*dstate_length];
+			float *hi = &si_rhi[node*w+k*dstate_length];
+			if(!sindex_contains(lo, hi, cond->lo, cond->hi))
+				continue;
+			ENTRY e = si_rref[node*SINDEX_FANOUT+k];
+			if(!si_rleaf[node])
+				stack[top++] = e.id;
+			else if(sindex_live(e))
+				set_add(set, si_cl[e.id]);
+		}
+	}
+}
+
+void sindex_general(NODE **set, COND *cond)
+{
+	// classifiers whose condition is more general than cond
+	NODE *cand = NULL;
+	sindex_contain(&cand, cond);
+	for(NODE *iter = cand; iter != NULL; iter = iter->next) {
+		if(cond_general(&iter->cl->cond, cond))
+			set_add(set, iter->cl);
+	}
+	set_free(&cand);
+}
+
+CL *sindex_duplicate(CL *c)
+{
+	// a classifier in the population that duplicates c; its box must
+	// contain c's
+	NODE *cand = NULL;
+	sindex_contain(&cand, &c->cond);
+	CL *d = NULL;
+	for(NODE *iter = cand; iter != NULL && d == NULL; iter = iter->next) {
+		if(cl_duplicate(c, iter->cl))
+			d = iter->cl;
+	}
+	set_free(&cand);
+	return d;
+}
+
+_Bool sindex_faster(double *dstate)
+{
+	// periodically counts the entries the index tests for the state and
+	// compares them with the classifiers a scan would test
+	if(si_calls % SINDEX_PERIOD == 0) {
+		NODE *set = NULL;
+		long tested = si_tested;
+		sindex_match(&set, dstate);
+		set_free(&set);
+		si_faster = (double)(si_tested - tested) * SINDEX_SCAN < pop_num;
+	}
+	si_calls++;
+	return si_faster;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+CL *sindex_duplicate(CL *c);
+_Bool sindex_faster(double *dstate);
+void sindex_add(CL *c);
+void sindex_del(CL *c);
+void sindex_free();
+void sindex_general(NODE **set, COND *cond);
+void sindex_init();
+void sindex_match(NODE **mset, double *dstate);
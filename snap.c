@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The population snapshot module.
+ *
+ * Publishes immutable flat copies of a population for threads that only
+ * read, such that the learner may continue to change the population. Readers
+ * bracket each use of a snapshot with snap_enter and snap_exit, which record
+ * the epoch current on entry in the reader's slot and never block. The writer
+ * swaps in the new snapshot and advances the epoch; a replaced snapshot is
+ * freed once no reader slot holds an epoch older than its replacement's.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "cond_interval.h"
+#include "snap.h"
+
+void snap_reclaim();
+void snap_release(SNAP *s);
+
+SNAP *_Atomic snap_cur; // the published snapshot
+atomic_long snap_epoch; // advanced after each publication
+atomic_long *snap_active; // epoch entered by each reader (0 = none)
+int snap_readers;
+SNAP **snap_retired; // replaced snapshots awaiting their readers
+long *snap_retired_epoch;
+int snap_retired_num;
+int snap_retired_cap;
+
+void snap_init(int readers)
+{
+	snap_readers = readers;
+	snap_active = malloc(sizeof(atomic_long)*readers);
+	for(int i = 0; i < readers; i++)
+		atomic_init(&snap_active[i], 0);
+	atomic_init(&snap_epoch, 1);
+	atomic_init(&snap_cur, NULL);
+	snap_retired = NULL;
+	snap_retired_epoch = NULL;
+	snap_retired_num = 0;
+	snap_retired_cap = 0;
+}
+
+void snap_free()
+{
+	// readers must have stopped
+	snap_release(atomic_load(&snap_cur));
+	for(int i = 0; i < snap_retired_num; i++)
+		snap_release(snap_retired[i]);
+	free(snap_retired);
+	free(snap_retired_epoch);
+	free(snap_active);
+}
+
+void snap_release(SNAP *s)
+{
+	if(s == NULL)
+		return;
+	free(s->cond);
+	free(s->act);
+	free(s->fit);
+	free(s->w);
+	free(s);
+}
+
+void snap_publish(NODE **set)
+{
+	// copy the set
+	SNAP *s = malloc(sizeof(SNAP));
+	s->num = 0;
+	s->coeffs = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next)
+		s->num++;
+	if(*set != NULL)
+		s->coeffs = pred_coeffs(&(*set)->cl->pred, NULL);
+	s->cond_size = (COND_TYPE == 1) 
+		? sizeof(float)*dstate_length*2 : sizeof(char)*state_length;
+	s->cond = malloc(s->cond_size*s->num + 1);
+	s->act = malloc(sizeof(int)*s->num + 1);
+	s->fit = malloc(sizeof(REAL)*s->num + 1);
+	s->w = malloc(sizeof(REAL)*s->coeffs*s->num + 1);
+	int i = 0;
+	for(NODE *iter = *set; iter != NULL; iter = iter->next, i++) {
+		CL *c = iter->cl;
+		cond_save(&c->cond, &s->cond[i*s->cond_size]);
+		s->act[i] = c->act.a;
+		s->fit[i] = c->fit;
+		pred_coeffs(&c->pred, &s->w[i*s->coeffs]);
+	}
+	// swap it in and retire the old one
+	s->epoch = atomic_load(&snap_epoch);
+	SNAP *old = atomic_exchange(&snap_cur, s);
+	long epoch = atomic_fetch_add(&snap_epoch, 1) + 1;
+	if(old != NULL) {
+		if(snap_retired_num == snap_retired_cap) {
+			snap_retired_cap = (snap_retired_cap == 0) ? 4 : snap_retired_cap * 2;
+			snap_retired = realloc(snap_retired, sizeof(SNAP*)*snap_retired_cap);
+			snap_retired_epoch = realloc(snap_retired_epoch, 
+					sizeof(long)*snap_retired_cap);
+		}
+		snap_retired[snap_retired_num] = old;
+		snap_retired_epoch[snap_retired_num++] = epoch;
+	}
+	snap_reclaim();
+}
+
+void snap_reclaim()
+{
+	// a reader that entered at or after a retirement epoch cannot hold the
+	// retired snapshot
+	long oldest = 0;
+	for(int i = 0; i < snap_readers; i++) {
+		long e = atomic_load(&snap_active[i]);
+		if(e != 0 && (oldest == 0 || e < oldest))
+			oldest = e;
+	}
+	int j = 0;
+	for(int i = 0; i < snap_retired_num; i++) {
+		if(oldest == 0 || snap_retired_epoch[i] <= oldest)
+			snap_release(snap_retired[i]);
+		else {
+			snap_retired[j] = snap_retired[i];
+			snap_retired_epoch[j++] = snap_retired_epoch[i];
+		}
+	}
+	snap_retired_num = j;
+}
+
+SNAP *snap_enter(int reader)
+{
+	// the snapshot stays valid until snap_exit; NULL before any publication
+	atomic_store(&snap_active[reader], atomic_load(&snap_epoch));
+	return atomic_load(&snap_cur);
+}
+
+void snap_exit(int reader)
+{
+	atomic_store(&snap_active[reader], 0);
+}
+
+int snap_action(SNAP *s, char *state, double *dstate, double *payoff)
+{
+	// the best action of the matching classifiers and its prediction, or -1
+	// if none match; the snapshot is not written
+	double pa[num_actions];
+	double nr[num_actions];
+	_Bool present[num_actions];
+	for(int i = 0; i < num_actions; i++) {
+		pa[i] = 0.0;
+		nr[i] = 0.0;
+		present[i] = false;
+	}
+	_Bool matched = false;
+	for(int i = 0; s != NULL && i < s->num; i++) {
+		char *cond = &s->cond[i*s->cond_size];
+		if(COND_TYPE == 1) {
+			float *bounds = (float *)cond;
+			if(!ivl_match_bounds(bounds, bounds+dstate_length, dstate))
+				continue;
+		}
+		else {
+			int j = 0;
+			while(j < state_length && (cond[j] == DONT_CARE || cond[j] == state[j]))
+				j++;
+			if(j < state_length)
+				continue;
+		}
+		matched = true;
+		pa[s->act[i]] += pred_eval(&s->w[i*s->coeffs], dstate) * s->fit[i];
+		nr[s->act[i]] += s->fit[i];
+		present[s->act[i]] = true;
+	}
+	*payoff = 0.0;
+	if(!matched)
+		return -1;
+	// only actions advocated by the matching classifiers compete
+	int action = -1;
+	for(int i = 0; i < num_actions; i++) {
+		pa[i] = (nr[i] != 0.0) ? pa[i] / nr[i] : 0.0;
+		if(present[i] && (action < 0 || pa[action] < pa[i]))
+			action = i;
+	}
+	*payoff = pa[action];
+	return action;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+typedef struct SNAP {
+	long epoch; // publication number
+	int num; // classifiers
+	int coeffs; // prediction coefficients per classifier
+	size_t cond_size; // bytes per condition
+	char *cond; // conditions as written by cond_save
+	int *act;
+	REAL *fit;
+	REAL *w; // prediction coefficients
+} SNAP;
+
+SNAP *snap_enter(int reader);
+int snap_action(SNAP *s, char *state, double *dstate, double *payoff);
+void snap_exit(int reader);
+void snap_free();
+void snap_init(int readers);
+void snap_publish(NODE **set);
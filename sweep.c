@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The parameter sweep module.
+ *
+ * Runs every configuration of the constants listed in the SWEEP file for
+ * NUM_EXPERIMENTS seeds each. A line NAME=a,b,c gives the values of a
+ * constant; NAME=lo:hi:n gives n evenly spaced values, and NAME=lo:hi a
+ * range (integer when both ends are) for random search. The full grid is run
+ * unless SWEEP_SAMPLES random configurations are requested. As a learner is
+ * held in the process globals, the configuration and seed jobs are run by
+ * SWEEP_WORKERS processes which each take the next job from a shared counter
+ * until none are left, so a slow job never holds up the others. Seed i of
+ * every configuration uses the same random number stream.
+ *
+ * Each job records its learning curve in shared memory. When all are done,
+ * the per-configuration means are written to a results table, with the
+ * performance at each quarter of the run, the final error and population
+ * size, the mean over the whole curve and the seconds per seed, and the
+ * mean curves are written to a second file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "perf.h"
+#include "xcs.h"
+#include "exp_single_step.h"
+#include "exp_multi_step.h"
+#include "sweep.h"
+
+#define SWEEP_AXES 16 // constants swept
+#define SWEEP_VALUES 64 // values per constant
+#define SWEEP_LEN 32 // characters per value
+#define SWEEP_MAX_CFGS 100000
+
+typedef struct AXIS {
+	char name[SWEEP_LEN];
+	int num; // values listed
+	char val[SWEEP_VALUES][SWEEP_LEN];
+	_Bool range; // drawn from [lo,hi] in random search
+	_Bool integer;
+	double lo;
+	double hi;
+} AXIS;
+
+typedef struct JOB {
+	int done; // 0 = not run, 1 = finished, -1 = the learner was rejected
+	int points; // learning curve points recorded
+	double time; // seconds taken
+} JOB;
+
+_Bool sweep_fixed(char *name);
+double sweep_time();
+void sweep_parse();
+void sweep_configs();
+void sweep_format(AXIS *a, double v, char *out);
+void sweep_report(double secs, int workers);
+void sweep_run(int argc, char **argv, int job);
+void sweep_worker(int argc, char **argv);
+
+AXIS sw_axis[SWEEP_AXES];
+int sw_axes;
+int sw_cfgs; // configurations
+char *sw_val; // value of each constant in each configuration
+int sw_jobs; // configurations x seeds
+int sw_points; // learning curve points per job
+atomic_int *sw_next; // shared next job to run
+JOB *sw_job; // shared state of each job
+double *sw_curve; // shared learning curve of each job
+
+void sweep_exp(int argc, char **argv)
+{
+	if(ISLANDS > 0 || HOGWILD > 0) {
+		printf("SWEEP needs ISLANDS=0 and HOGWILD=0\n");
+		exit(EXIT_FAILURE);
+	}
+	sweep_parse();
+	sweep_configs();
+	sw_jobs = sw_cfgs * NUM_EXPERIMENTS;
+	sw_points = MAX_TRIALS / PERF_AVG_TRIALS + 1;
+	// the curves first so that they stay aligned
+	size_t curve_size = sizeof(double)*sw_jobs*sw_points*4;
+	size_t size = curve_size + sizeof(JOB)*sw_jobs + sizeof(atomic_int);
+	char *shm = mmap(NULL, size, PROT_READ | PROT_WRITE, 
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(shm == MAP_FAILED) {
+		printf("Error allocating sweep memory\n");
+		exit(EXIT_FAILURE);
+	}
+	sw_curve = (double *)shm;
+	sw_job = (JOB *)(shm + curve_size);
+	sw_next = (atomic_int *)(shm + curve_size + sizeof(JOB)*sw_jobs);
+	atomic_init(sw_next, 0);
+	for(int j = 0; j < sw_jobs; j++) {
+		sw_job[j].done = 0;
+		sw_job[j].points = 0;
+		sw_job[j].time = 0.0;
+	}
+
+	// start the workers
+	int workers = SWEEP_WORKERS;
+	if(workers < 1)
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if(workers > sw_jobs)
+		workers = sw_jobs;
+	if(workers < 1)
+		workers = 1;
+	printf("sweep: %d configurations x %d seeds on %d workers\n", 
+			sw_cfgs, NUM_EXPERIMENTS, workers);
+	pid_t pids[workers];
+	fflush(NULL);
+	double start = sweep_time();
+	for(int i = 0; i < workers; i++) {
+		if((pids[i] = fork()) < 0) {
+			printf("Error starting sweep worker %d\n", i);
+			exit(EXIT_FAILURE);
+		}
+		if(pids[i] == 0)
+			sweep_worker(argc, argv);
+	}
+	for(int i = 0; i < workers; i++)
+		waitpid(pids[i], NULL, 0);
+	sweep_report(sweep_time() - start, workers);
+	munmap(shm, size);
+	free(sw_val);
+}
+
+void sweep_worker(int argc, char **argv)
+{
+	// runs in the worker's own process and does not return
+	freopen("/dev/null", "w", stdout);
+	int j;
+	while((j = atomic_fetch_add(sw_next, 1)) < sw_jobs)
+		sweep_run(argc, argv, j);
+	fflush(NULL);
+	_exit(EXIT_SUCCESS);
+}
+
+void sweep_run(int argc, char **argv, int job)
+{
+	// one seed of one configuration
+	int cfg = job / NUM_EXPERIMENTS;
+	constants_override(NULL, NULL);
+	for(int a = 0; a < sw_axes; a++)
+		constants_override(sw_axis[a].name, &sw_val[(cfg*sw_axes+a)*SWEEP_LEN]);
+	XCS_PARAMS p;
+	constants_init(argc, argv, &p);
+	p.state_length = state_length;
+	p.dstate_length = dstate_length;
+	p.num_actions = num_actions;
+	p.seed = job % NUM_EXPERIMENTS + 1;
+	double start = sweep_time();
+	XCS *xcs = xcs_create(&p);
+	if(xcs == NULL) {
+		sw_job[job].done = -1;
+		return;
+	}
+	int perf[PERF_AVG_TRIALS];
+	double err[PERF_AVG_TRIALS];
+	perf_rec = &sw_curve[job*sw_points*4];
+	perf_rec_num = 0;
+	perf_rec_cap = sw_points;
+	if(multi_step)
+		multi_step_exp(perf, err);
+	else
+		single_step_exp(xcs, perf, err);
+	xcs_destroy(xcs);
+	perf_rec = NULL;
+	sw_job[job].points = perf_rec_num;
+	sw_job[job].time = sweep_time() - start;
+	sw_job[job].done = 1;
+}
+
+_Bool sweep_fixed(char *name)
+{
+	// constants that shape the sweep itself
+	char *fixed[] = {"MAX_TRIALS", "NUM_EXPERIMENTS", "PERF_AVG_TRIALS", 
+		"ISLANDS", "HOGWILD", "SWEEP", "SWEEP_WORKERS", "SWEEP_SAMPLES"};
+	for(size_t i = 0; i < sizeof(fixed)/sizeof(fixed[0]); i++) {
+		if(strcmp(name, fixed[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+void sweep_parse()
+{
+	FILE *f = fopen(SWEEP, "rt");
+	if(f == NULL) {
+		printf("Error opening sweep file: %s\n", SWEEP);
+		exit(EXIT_FAILURE);
+	}
+	char line[1024];
+	sw_axes = 0;
+	while(fgets(line, sizeof(line), f) != NULL) {
+		// strip the line ending and blanks; ; starts a comment
+		char *s = line;
+		while(*s == ' ' || *s == '\t')
+			s++;
+		s[strcspn(s, " \t\r\n")] = '\0';
+		if(s[0] == '\0' || s[0] == ';')
+			continue;
+		char *eq = strchr(s, '=');
+		if(eq == NULL || eq == s || eq[1] == '\0' || eq - s >= SWEEP_LEN) {
+			printf("Invalid sweep line: %s\n", s);
+			exit(EXIT_FAILURE);
+		}
+		*eq = '\0';
+		if(sw_axes == SWEEP_AXES || sweep_fixed(s) || !constants_exists(s)) {
+			printf("Cannot sweep: %s\n", s);
+			exit(EXIT_FAILURE);
+		}
+		AXIS *a = &sw_axis[sw_axes++];
+		strcpy(a->name, s);
+		a->num = 0;
+		char *v = eq + 1;
+		a->range = (strchr(v, ':') != NULL);
+		if(a->range) {
+			// lo:hi for random search, lo:hi:n for n evenly spaced values
+			int n = 0;
+			if(sscanf(v, "%lf:%lf:%d", &a->lo, &a->hi, &n) < 2 
+					|| n < 0 || n > SWEEP_VALUES) {
+				printf("Invalid sweep range: %s=%s\n", a->name, v);
+				exit(EXIT_FAILURE);
+			}
+			a->integer = (strpbrk(v, ".eE") == NULL);
+			for(int i = 0; i < n; i++) {
+				double x = (n == 1) ? a->lo : a->lo + (a->hi - a->lo) * i / (n-1);
+				sweep_format(a, x, a->val[a->num++]);
+			}
+		}
+		else {
+			for(char *t = strtok(v, ","); t != NULL; t = strtok(NULL, ",")) {
+				if(a->num == SWEEP_VALUES || strlen(t) >= SWEEP_LEN) {
+					printf("Too many or too long sweep values: %s\n", a->name);
+					exit(EXIT_FAILURE);
+				}
+				strcpy(a->val[a->num++], t);
+			}
+		}
+		if(a->num == 0 && SWEEP_SAMPLES < 1) {
+			printf("The grid needs values for %s (lo:hi:n)\n", a->name);
+			exit(EXIT_FAILURE);
+		}
+	}
+	fclose(f);
+	if(sw_axes == 0) {
+		printf("Nothing to sweep in %s\n", SWEEP);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void sweep_format(AXIS *a, double v, char *out)
+{
+	if(a->integer)
+		snprintf(out, SWEEP_LEN, "%ld", lround(v));
+	else
+		snprintf(out, SWEEP_LEN, "%g", v);
+}
+
+void sweep_configs()
+{
+	// the full grid in row-major order, or random draws
+	if(SWEEP_SAMPLES > 0)
+		sw_cfgs = SWEEP_SAMPLES;
+	else {
+		sw_cfgs = 1;
+		for(int a = 0; a < sw_axes; a++) {
+			if(sw_cfgs > SWEEP_MAX_CFGS / sw_axis[a].num) {
+				printf("Sweep grid larger than %d configurations\n", SWEEP_MAX_CFGS);
+				exit(EXIT_FAILURE);
+			}
+			sw_cfgs *= sw_axis[a].num;
+		}
+	}
+	sw_val = malloc(sizeof(char)*sw_cfgs*sw_axes*SWEEP_LEN);
+	for(int c = 0; c < sw_cfgs; c++) {
+		int rem = c;
+		for(int a = sw_axes-1; a >= 0; a--) {
+			AXIS *ax = &sw_axis[a];
+			char *out = &sw_val[(c*sw_axes+a)*SWEEP_LEN];
+			if(SWEEP_SAMPLES <= 0) {
+				strcpy(out, ax->val[rem % ax->num]);
+				rem /= ax->num;
+			}
+			else if(ax->range && ax->integer)
+				sweep_format(ax, irand(lround(ax->lo), lround(ax->hi)+1), out);
+			else if(ax->range)
+				sweep_format(ax, ax->lo + (ax->hi - ax->lo) * drand(), out);
+			else
+				strcpy(out, ax->val[irand(0, ax->num)]);
+		}
+	}
+}
+
+void sweep_report(double secs, int workers)
+{
+	// per-configuration means over the seeds that finished
+	FILE *table = outfile_open("sweep");
+	FILE *curves = outfile_open("sweep-curves");
+	FILE *out[2] = {stdout, table};
+	for(int o = 0; o < 2; o++) {
+		fprintf(out[o], "# cfg");
+		for(int a = 0; a < sw_axes; a++)
+			fprintf(out[o], " %s", sw_axis[a].name);
+		fprintf(out[o], " seeds perf25 perf50 perf75 perf100 err100 "
+				"perfmean macro secs\n");
+	}
+	fprintf(curves, "# cfg trial perf err macro\n");
+	double busy = 0.0;
+	int best = -1;
+	double best_mean = 0.0;
+	for(int c = 0; c < sw_cfgs; c++) {
+		// seeds finished and the curve length they share
+		int n = 0;
+		int points = sw_points;
+		for(int s = 0; s < NUM_EXPERIMENTS; s++) {
+			JOB *job = &sw_job[c*NUM_EXPERIMENTS+s];
+			busy += job->time;
+			if(job->done == 1) {
+				n++;
+				if(job->points < points)
+					points = job->points;
+			}
+		}
+		for(int o = 0; o < 2; o++) {
+			fprintf(out[o], "%d", c);
+			for(int a = 0; a < sw_axes; a++)
+				fprintf(out[o], " %s", &sw_val[(c*sw_axes+a)*SWEEP_LEN]);
+		}
+		if(n == 0 || points == 0) {
+			for(int o = 0; o < 2; o++)
+				fprintf(out[o], " 0 failed\n");
+			continue;
+		}
+		// mean curve
+		double mean[points*4];
+		double secs_sum = 0.0;
+		double perf_sum = 0.0;
+		for(int i = 0; i < points*4; i++)
+			mean[i] = 0.0;
+		for(int s = 0; s < NUM_EXPERIMENTS; s++) {
+			int j = c*NUM_EXPERIMENTS+s;
+			if(sw_job[j].done != 1)
+				continue;
+			secs_sum += sw_job[j].time;
+			for(int i = 0; i < points*4; i++)
+				mean[i] += sw_curve[j*sw_points*4+i] / n;
+		}
+		for(int i = 0; i < points; i++) {
+			perf_sum += mean[i*4+1];
+			fprintf(curves, "%d %.0f %.5f %.5f %.1f\n", c, mean[i*4], 
+					mean[i*4+1], mean[i*4+2], mean[i*4+3]);
+		}
+		double perf_mean = perf_sum / points;
+		for(int o = 0; o < 2; o++) {
+			fprintf(out[o], " %d", n);
+			for(int q = 1; q <= 4; q++) {
+				int i = (points*q)/4 - 1;
+				fprintf(out[o], " %.5f", mean[(i < 0 ? 0 : i)*4+1]);
+			}
+			fprintf(out[o], " %.5f %.5f %.1f %.3f\n", mean[(points-1)*4+2], 
+					perf_mean, mean[(points-1)*4+3], secs_sum / n);
+		}
+		// steps to the goal are minimised in multi-step problems
+		if(best < 0 || (multi_step ? perf_mean < best_mean : perf_mean > best_mean)) {
+			best = c;
+			best_mean = perf_mean;
+		}
+	}
+	if(best >= 0) {
+		printf("sweep: best configuration %d:", best);
+		for(int a = 0; a < sw_axes; a++)
+			printf(" %s=%s", sw_axis[a].name, &sw_val[(best*sw_axes+a)*SWEEP_LEN]);
+		printf("\n");
+	}
+	printf("sweep: %d jobs in %.3fs on %d workers (%.3fs of learning)\n", 
+			sw_jobs, secs, workers, busy);
+	fclose(table);
+	fclose(curves);
+}
+
+double sweep_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
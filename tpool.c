@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The thread pool module.
+ *
+ * A persistent set of worker threads that, together with the calling thread,
+ * process the numbered chunks of a job. Chunks are claimed from a shared
+ * counter so the split of work between threads varies, but each chunk is
+ * always processed whole by one thread; callers that keep per-chunk results
+ * and combine them in chunk order therefore obtain the same answer for any
+ * number of threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "tpool.h"
+
+void *tpool_worker(void *arg);
+void tpool_work();
+
+pthread_t *tp_threads;
+int tp_num;
+pthread_mutex_t tp_lock;
+pthread_cond_t tp_start;
+pthread_cond_t tp_done;
+long tp_job; // incremented for every job
+int tp_busy; // workers still on the current job
+_Bool tp_quit;
+void (*tp_func)(int chunk, void *arg);
+void *tp_arg;
+int tp_chunks;
+atomic_int tp_next; // next unclaimed chunk
+
+_Bool tpool_init(int threads)
+{
+	// the calling thread also works, so start one fewer
+	int num = (threads > 1) ? threads-1 : 0;
+	tp_num = 0;
+	tp_job = 0;
+	tp_busy = 0;
+	tp_quit = false;
+	pthread_mutex_init(&tp_lock, NULL);
+	pthread_cond_init(&tp_start, NULL);
+	pthread_cond_init(&tp_done, NULL);
+	tp_threads = malloc(sizeof(pthread_t)*(num+1));
+	for(int i = 0; i < num; i++) {
+		if(pthread_create(&tp_threads[i], NULL, tpool_worker, NULL) != 0)
+			return false;
+		tp_num++;
+	}
+	return true;
+}
+
+void tpool_free()
+{
+	pthread_mutex_lock(&tp_lock);
+	tp_quit = true;
+	pthread_cond_broadcast(&tp_start);
+	pthread_mutex_unlock(&tp_lock);
+	for(int i = 0; i < tp_num; i++)
+		pthread_join(tp_threads[i], NULL);
+	free(tp_threads);
+	pthread_mutex_destroy(&tp_lock);
+	pthread_cond_destroy(&tp_start);
+	pthread_cond_destroy(&tp_done);
+}
+
+void tpool_work()
+{
+	int chunk;
+	while((chunk = atomic_fetch_add(&tp_next, 1)) < tp_chunks)
+		tp_func(chunk, tp_arg);
+}
+
+void *tpool_worker(void *arg)
+{
+	(void)arg;
+	long seen = 0;
+	pthread_mutex_lock(&tp_lock);
+	while(true) {
+		while(tp_job == seen && !tp_quit)
+			pthread_cond_wait(&tp_start, &tp_lock);
+		if(tp_quit)
+			break;
+		seen = tp_job;
+		pthread_mutex_unlock(&tp_lock);
+		tpool_work();
+		pthread_mutex_lock(&tp_lock);
+		tp_busy--;
+		if(tp_busy == 0)
+			pthread_cond_signal(&tp_done);
+	}
+	pthread_mutex_unlock(&tp_lock);
+	return NULL;
+}
+
+void tpool_run(void (*func)(int chunk, void *arg), void *arg, int chunks)
+{
+	// runs func on chunks [0,chunks) and returns once all are finished
+	tp_func = func;
+	tp_arg = arg;
+	tp_chunks = chunks;
+	atomic_store(&tp_next, 0);
+	if(tp_num == 0 || chunks < 2) {
+		tpool_work();
+		return;
+	}
+	pthread_mutex_lock(&tp_lock);
+	tp_busy = tp_num;
+	tp_job++;
+	pthread_cond_broadcast(&tp_start);
+	pthread_mutex_unlock(&tp_lock);
+	tpool_work();
+	pthread_mutex_lock(&tp_lock);
+	while(tp_busy > 0)
+		pthread_cond_wait(&tp_done, &tp_lock);
+	pthread_mutex_unlock(&tp_lock);
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The ternary trie population index module.
+ *
+ * The conditions of the population are kept in a path-compressed trie with
+ * one branch for each of '0', '1' and DONT_CARE. A node holds the run of
+ * alleles shared by all conditions below it and a leaf holds the classifiers
+ * having that condition, whatever their action. Match, generalisation,
+ * specialisation, duplicate and covering queries descend only the branches
+ * that can contain an answer, so their cost follows the size of the answer
+ * rather than the population. The trie is updated through the population's
+ * index hooks, i.e., by covering, GA insertion, deletion and subsumption.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "trie.h"
+
+typedef struct TRIE {
+	int pos; // first allele of the label
+	int len; // alleles in the label
+	char *label;
+	struct TRIE *child[3]; // by the allele following the label
+	CL **cl; // classifiers with the condition ending at this leaf
+	int num;
+	int cap;
+} TRIE;
+
+TRIE *trie_leaf(char *s, int pos, CL *c);
+TRIE *trie_node(char *s, int pos, int len);
+_Bool trie_covers_node(TRIE *n, char *state, int action);
+int trie_sym(char a);
+void trie_free_node(TRIE *n);
+void trie_general_node(TRIE *n, NODE **set, COND *cond);
+void trie_leaf_add(TRIE *n, CL *c);
+void trie_match_node(TRIE *n, NODE **mset, char *state);
+void trie_specific_node(TRIE *n, NODE **set, COND *cond);
+
+TRIE *tr_root; // empty label; never split or merged
+
+void trie_init()
+{
+	tr_root = trie_node(NULL, 0, 0);
+}
+
+void trie_free()
+{
+	trie_free_node(tr_root);
+}
+
+void trie_free_node(TRIE *n)
+{
+	for(int i = 0; i < 3; i++) {
+		if(n->child[i] != NULL)
+			trie_free_node(n->child[i]);
+	}
+	free(n->label);
+	free(n->cl);
+	free(n);
+}
+
+int trie_sym(char a)
+{
+	if(a == DONT_CARE)
+		return 2;
+	return a - '0';
+}
+
+TRIE *trie_node(char *s, int pos, int len)
+{
+	TRIE *n = malloc(sizeof(TRIE));
+	n->pos = pos;
+	n->len = len;
+	n->label = malloc(sizeof(char)*(len+1));
+	if(len > 0)
+		memcpy(n->label, &s[pos], sizeof(char)*len);
+	for(int i = 0; i < 3; i++)
+		n->child[i] = NULL;
+	n->cl = NULL;
+	n->num = 0;
+	n->cap = 0;
+	return n;
+}
+
+TRIE *trie_leaf(char *s, int pos, CL *c)
+{
+	TRIE *n = trie_node(s, pos, state_length - pos);
+	trie_leaf_add(n, c);
+	return n;
+}
+
+void trie_leaf_add(TRIE *n, CL *c)
+{
+	if(n->num == n->cap) {
+		n->cap = (n->cap == 0) ? 2 : n->cap * 2;
+		n->cl = realloc(n->cl, sizeof(CL*)*n->cap);
+	}
+	n->cl[n->num++] = c;
+}
+
+void trie_add(CL *c)
+{
+	char *s = c->cond.string;
+	TRIE **link = &tr_root;
+	while(true) {
+		TRIE *n = *link;
+		int k = 0;
+		while(k < n->len && n->label[k] == s[n->pos+k])
+			k++;
+		if(k < n->len) {
+			// split the label where the condition departs from it
+			TRIE *m = trie_node(n->label, 0, k);
+			m->pos = n->pos;
+			m->child[trie_sym(n->label[k])] = n;
+			m->child[trie_sym(s[n->pos+k])] = trie_leaf(s, n->pos+k+1, c);
+			memmove(n->label, &n->label[k+1], sizeof(char)*(n->len-k-1));
+			n->pos += k+1;
+			n->len -= k+1;
+			*link = m;
+			return;
+		}
+		int end = n->pos + n->len;
+		if(end == state_length) {
+			trie_leaf_add(n, c);
+			return;
+		}
+		link = &n->child[trie_sym(s[end])];
+		if(*link == NULL) {
+			*link = trie_leaf(s, end+1, c);
+			return;
+		}
+	}
+}
+
+void trie_del(CL *c)
+{
+	// the path is followed by the condition alone as it is in the trie
+	char *s = c->cond.string;
+	TRIE **path[state_length+2];
+	int d = 0;
+	TRIE **link = &tr_root;
+	while(true) {
+		path[d++] = link;
+		TRIE *n = *link;
+		int end = n->pos + n->len;
+		if(end == state_length)
+			break;
+		link = &n->child[trie_sym(s[end])];
+	}
+	TRIE *leaf = *path[d-1];
+	for(int i = 0; i < leaf->num; i++) {
+		if(leaf->cl[i] == c) {
+			leaf->cl[i] = leaf->cl[--leaf->num];
+			break;
+		}
+	}
+	if(leaf->num > 0 || d < 2)
+		return;
+	trie_free_node(leaf);
+	*path[d-1] = NULL;
+	// a branch left with one child is merged into it
+	if(d < 3)
+		return;
+	TRIE *p = *path[d-2];
+	int only = -1, count = 0;
+	for(int i = 0; i < 3; i++) {
+		if(p->child[i] != NULL) {
+			only = i;
+			count++;
+		}
+	}
+	if(count != 1)
+		return;
+	TRIE *ch = p->child[only];
+	char *label = malloc(sizeof(char)*(p->len+ch->len+2));
+	memcpy(label, p->label, sizeof(char)*p->len);
+	label[p->len] = (only == 2) ? DONT_CARE : '0' + only;
+	memcpy(&label[p->len+1], ch->label, sizeof(char)*ch->len);
+	free(ch->label);
+	ch->label = label;
+	ch->len += p->len + 1;
+	ch->pos = p->pos;
+	*path[d-2] = ch;
+	p->child[only] = NULL;
+	trie_free_node(p);
+}
+
+CL *trie_duplicate(CL *c)
+{
+	// a classifier in the population that duplicates c; only those with
+	// the same condition string can
+	char *s = c->cond.string;
+	TRIE *n = tr_root;
+	while(n != NULL) {
+		if(memcmp(n->label, &s[n->pos], sizeof(char)*n->len) != 0)
+			return NULL;
+		int end = n->pos + n->len;
+		if(end == state_length) {
+			for(int i = 0; i < n->num; i++) {
+				if(cl_duplicate(c, n->cl[i]))
+					return n->cl[i];
+			}
+			return NULL;
+		}
+		n = n->child[trie_sym(s[end])];
+	}
+	return NULL;
+}
+
+void trie_match(NODE **mset, char *state)
+{
+	trie_match_node(tr_root, mset, state);
+	set_order(mset);
+}
+
+void trie_match_node(TRIE *n, NODE **mset, char *state)
+{
+	for(int i = 0; i < n->len; i++) {
+		char a = n->label[i];
+		if(a != DONT_CARE && a != state[n->pos+i])
+			return;
+	}
+	int end = n->pos + n->len;
+	if(end == state_length) {
+		for(int i = 0; i < n->num; i++)
+			set_add(mset, n->cl[i]);
+		return;
+	}
+	TRIE *b = n->child[trie_sym(state[end])];
+	if(b != NULL)
+		trie_match_node(b, mset, state);
+	if(n->child[2] != NULL)
+		trie_match_node(n->child[2], mset, state);
+}
+
+_Bool trie_covers(char *state, int action)
+{
+	// whether any classifier advocating the action matches the state
+	return trie_covers_node(tr_root, state, action);
+}
+
+_Bool trie_covers_node(TRIE *n, char *state, int action)
+{
+	for(int i = 0; i < n->len; i++) {
+		char a = n->label[i];
+		if(a != DONT_CARE && a != state[n->pos+i])
+			return false;
+	}
+	int end = n->pos + n->len;
+	if(end == state_length) {
+		for(int i = 0; i < n->num; i++) {
+			if(n->cl[i]->act.a == action)
+				return true;
+		}
+		return false;
+	}
+	TRIE *b = n->child[trie_sym(state[end])];
+	if(b != NULL && trie_covers_node(b, state, action))
+		return true;
+	return n->child[2] != NULL && trie_covers_node(n->child[2], state, action);
+}
+
+void trie_general(NODE **set, COND *cond)
+{
+	// classifiers whose condition is more general than cond
+	trie_general_node(tr_root, set, cond);
+}
+
+void trie_general_node(TRIE *n, NODE **set, COND *cond)
+{
+	char *s = cond->string;
+	for(int i = 0; i < n->len; i++) {
+		char a = n->label[i];
+		if(a != DONT_CARE && a != s[n->pos+i])
+			return;
+	}
+	int end = n->pos + n->len;
+	if(end == state_length) {
+		for(int i = 0; i < n->num; i++) {
+			if(cond_general(&n->cl[i]->cond, cond))
+				set_add(set, n->cl[i]);
+		}
+		return;
+	}
+	if(s[end] != DONT_CARE && n->child[trie_sym(s[end])] != NULL)
+		trie_general_node(n->child[trie_sym(s[end])], set, cond);
+	if(n->child[2] != NULL)
+		trie_general_node(n->child[2], set, cond);
+}
+
+void trie_specific(NODE **set, COND *cond)
+{
+	// classifiers whose condition cond is more general than
+	trie_specific_node(tr_root, set, cond);
+}
+
+void trie_specific_node(TRIE *n, NODE **set, COND *cond)
+{
+	char *s = cond->string;
+	for(int i = 0; i < n->len; i++) {
+		char a = s[n->pos+i];
+		if(a != DONT_CARE && a != n->label[i])
+			return;
+	}
+	int end = n->pos + n->len;
+	if(end == state_length) {
+		for(int i = 0; i < n->num; i++) {
+			if(cond_general(cond, &n->cl[i]->cond))
+				set_add(set, n->cl[i]);
+		}
+		return;
+	}
+	for(int i = 0; i < 3; i++) {
+		if(n->child[i] != NULL && (s[end] == DONT_CARE || i == trie_sym(s[end])))
+			trie_specific_node(n->child[i], set, cond);
+	}
+}
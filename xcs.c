@@ -0,0 +1,444 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **************
+ * Description: 
+ **************
+ * The library interface module.
+ *
+ * Creates a learner from a parameter structure and trains it on, or queries
+ * it with, batches of single-step problem instances supplied in caller owned
+ * arrays. States are state_length characters of '0' or '1' each; the real
+ * inputs used by computed prediction are either supplied alongside or derived
+ * from the bits as -1/+1. Training rewards give the payoff each action would
+ * receive, num_actions values per instance. Populations are saved to and
+ * loaded from memory buffers; the library performs no file or console I/O.
+ *
+ * For serving, xcs_publish makes an immutable copy of the population that
+ * other threads query with xcs_serve_action while the learner keeps training,
+ * e.g., with xcs_update on the rewards received for the served actions. All
+ * other functions must be called from one thread.
+ *
+ * The learner is held in the module globals, so only one may exist at a time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cons.h"
+#include "random.h"
+#include "cl.h"
+#include "cl_set.h"
+#include "pa.h"
+#include "ga.h"
+#include "tpool.h"
+#include "snap.h"
+#include "batch.h"
+#include "kern.h"
+#include "xcs.h"
+
+#if defined(CONSTANT_PREDICTION)
+#define XCS_PRED 0
+#elif defined(NLMS_PREDICTION)
+#define XCS_PRED 1
+#else
+#define XCS_PRED 2
+#endif
+#ifdef QUADRATIC
+#define XCS_QUAD 1
+#else
+#define XCS_QUAD 0
+#endif
+#ifdef FLOAT_STORAGE
+#define XCS_REAL 1
+#else
+#define XCS_REAL 0
+#endif
+#ifdef SELF_ADAPT_MUTATION
+#define XCS_MU NUM_MU
+#else
+#define XCS_MU 0
+#endif
+
+#define XCS_HEADER 8 // ints before the classifiers
+
+struct XCS {
+	int time; // number of training instances seen
+	double *dstate; // real input derived from the bits
+	double *batch; // real inputs of a batch derived from the bits
+};
+
+double *xcs_dstate(XCS *x, const char *state, const double *dstate);
+int xcs_check(const void *buf, size_t size);
+size_t xcs_cl_size();
+void xcs_set_params(const XCS_PARAMS *p);
+
+void xcs_default_params(XCS_PARAMS *p)
+{
+	// the values distributed in cons.txt
+	memset(p, 0, sizeof(XCS_PARAMS));
+	p->pop_size = 800;
+	p->pop_init = false;
+	p->alpha = 0.1;
+	p->beta = 0.2;
+	p->delta = 0.1;
+	p->eps_0 = 10.0;
+	p->err_reduc = 0.25;
+	p->fit_reduc = 0.1;
+	p->gamma = 0.95;
+	p->init_error = 0.0;
+	p->init_fitness = 0.01;
+	p->nu = 5.0;
+	p->theta_del = 20.0;
+	p->p_crossover = 0.8;
+	p->p_mutation = 0.04;
+	p->theta_ga = 25.0;
+	p->theta_mna = 0;
+	p->ga_queue = 0;
+	p->ga_stale = 100;
+	p->mu_eps_0 = 0.01;
+	p->num_mu = 1;
+	p->p_dontcare = 0.5;
+	p->cond_type = 0;
+	p->cond_s0 = 1.0;
+	p->cond_m0 = 0.1;
+	p->init_prediction = 10.0;
+	p->xcsf_eta = 0.2;
+	p->xcsf_x0 = 1.0;
+	p->action_subsumption = true;
+	p->ga_subsumption = true;
+	p->theta_sub = 20.0;
+	p->match_cache_size = 0;
+	p->match_delta = false;
+	p->match_index = 0;
+	p->num_threads = 1;
+	p->par_match_min = 20000;
+	p->par_pa_min = 2000;
+	p->infer_table_bits = 20;
+	p->batch_size = 1;
+	p->serve_readers = 16;
+}
+
+void xcs_set_params(const XCS_PARAMS *p)
+{
+	state_length = p->state_length;
+	dstate_length = (p->dstate_length > 0) ? p->dstate_length : p->state_length;
+	num_actions = p->num_actions;
+	POP_INIT = p->pop_init;
+	POP_SIZE = p->pop_size;
+	ALPHA = p->alpha;
+	BETA = p->beta;
+	DELTA = p->delta;
+	EPS_0 = p->eps_0;
+	ERR_REDUC = p->err_reduc;
+	FIT_REDUC = p->fit_reduc;
+	GAMMA = p->gamma;
+	INIT_ERROR = p->init_error;
+	INIT_FITNESS = p->init_fitness;
+	NU = p->nu;
+	THETA_DEL = p->theta_del;
+	P_CROSSOVER = p->p_crossover;
+	P_MUTATION = p->p_mutation;
+	THETA_GA = p->theta_ga;
+	THETA_MNA = p->theta_mna;
+	GA_QUEUE = p->ga_queue;
+	GA_STALE = p->ga_stale;
+	muEPS_0 = p->mu_eps_0;
+	NUM_MU = p->num_mu;
+	DONT_CARE = '#';
+	P_DONTCARE = p->p_dontcare;
+	COND_TYPE = p->cond_type;
+	COND_S0 = p->cond_s0;
+	COND_M0 = p->cond_m0;
+	INIT_PREDICTION = p->init_prediction;
+	XCSF_ETA = p->xcsf_eta;
+	XCSF_X0 = p->xcsf_x0;
+	ACTION_SUBSUMPTION = p->action_subsumption;
+	GA_SUBSUMPTION = p->ga_subsumption;
+	THETA_SUB = p->theta_sub;
+	MATCH_CACHE_SIZE = p->match_cache_size;
+	MATCH_DELTA = p->match_delta;
+	MATCH_INDEX = p->match_index;
+	NUM_THREADS = p->num_threads;
+	PAR_MATCH_MIN = p->par_match_min;
+	PAR_PA_MIN = p->par_pa_min;
+	INFER_TABLE_BITS = p->infer_table_bits;
+	BATCH_SIZE = p->batch_size;
+	SERVE_READERS = p->serve_readers;
+}
+
+XCS *xcs_create(const XCS_PARAMS *p)
+{
+	if(p->state_length < 1 || p->num_actions < 1 || p->dstate_length < 0
+			|| p->serve_readers < 1 || p->ga_queue < 0 
+			|| p->cond_type < 0 || p->cond_type > 2)
+		return NULL;
+	// the match caches, the trie and batches work on ternary conditions
+	if(p->cond_type == 1 && (p->match_cache_size > 0 || p->match_delta 
+				|| p->match_index == 3 || p->batch_size > 1))
+		return NULL;
+	// sparse conditions have no strings for the indexes and batches
+	if(p->cond_type == 2 && (p->match_delta || p->match_index != 0 
+				|| p->batch_size > 1))
+		return NULL;
+	xcs_set_params(p);
+	kern_init();
+	if(p->seed != 0)
+		random_seed(p->seed);
+	if(!tpool_init(NUM_THREADS)) {
+		tpool_free();
+		return NULL;
+	}
+	XCS *x = malloc(sizeof(XCS));
+	x->time = 0;
+	x->dstate = malloc(sizeof(double)*dstate_length);
+	x->batch = NULL;
+	if(BATCH_SIZE > 1)
+		x->batch = malloc(sizeof(double)*dstate_length*BATCH_SIZE);
+	pop_init();
+	pa_init();
+	snap_init(SERVE_READERS);
+	return x;
+}
+
+void xcs_destroy(XCS *x)
+{
+	snap_free();
+	pa_free();
+	pop_free();
+	tpool_free();
+	free(x->dstate);
+	free(x->batch);
+	free(x);
+}
+
+double *xcs_dstate(XCS *x, const char *state, const double *dstate)
+{
+	if(dstate != NULL)
+		return (double *)dstate;
+	for(int i = 0; i < dstate_length; i++)
+		x->dstate[i] = (i < state_length && state[i] == '1') ? 1.0 : -1.0;
+	return x->dstate;
+}
+
+int xcs_train_batch(XCS *x, const char *states, const double *dstates, 
+		const double *rewards, int n)
+{
+	if(BATCH_SIZE > 1) {
+		// explore batch_size instances at a time
+		for(int i = 0; i < n; i += BATCH_SIZE) {
+			int b = (n - i < BATCH_SIZE) ? n - i : BATCH_SIZE;
+			char *state = (char *)&states[i*state_length];
+			double *dstate = dstates ? (double *)&dstates[i*dstate_length] 
+				: x->batch;
+			if(dstates == NULL) {
+				for(int j = 0; j < b; j++)
+					memcpy(&x->batch[j*dstate_length], xcs_dstate(x, 
+								&state[j*state_length], NULL), 
+							sizeof(double)*dstate_length);
+			}
+			batch_train(state, dstate, (double *)&rewards[i*num_actions], b, 
+					x->time);
+			x->time += b;
+		}
+		return 0;
+	}
+	// one explore trial per instance
+	for(int i = 0; i < n; i++) {
+		char *state = (char *)&states[i*state_length];
+		double *dstate = xcs_dstate(x, state, 
+				dstates ? &dstates[i*dstate_length] : NULL);
+		NODE *mset = NULL, *aset = NULL, *kset = NULL;
+		set_match(&mset, state, dstate, x->time, &kset);
+		pa_build(&mset, dstate);
+		int action = pa_rand_action();
+		int anum = 0;
+		int asize = pa_set_action(&aset, action, &anum);
+		double reward = rewards[i*num_actions+action];
+		set_update(&aset, &asize, &anum, 0.0, reward, &kset, dstate);
+		ga(&aset, asize, anum, x->time, state, &kset);
+		set_free(&aset);
+		set_free(&mset);
+		set_kill(&kset);
+		x->time++;
+	}
+	return 0;
+}
+
+int xcs_update(XCS *x, const char *state, const double *dstate, int action, 
+		double reward)
+{
+	// one trial in which the action was chosen elsewhere, e.g., the feedback
+	// to a decision served from a snapshot
+	if(action < 0 || action >= num_actions)
+		return -1;
+	char *s = (char *)state;
+	double *ds = xcs_dstate(x, s, dstate);
+	NODE *mset = NULL, *aset = NULL, *kset = NULL;
+	set_match(&mset, s, ds, x->time, &kset);
+	pa_build(&mset, ds);
+	int anum = 0;
+	int asize = pa_set_action(&aset, action, &anum);
+	if(asize > 0) {
+		set_update(&aset, &asize, &anum, 0.0, reward, &kset, ds);
+		ga(&aset, asize, anum, x->time, s, &kset);
+	}
+	set_free(&aset);
+	set_free(&mset);
+	set_kill(&kset);
+	x->time++;
+	return 0;
+}
+
+void xcs_publish(XCS *x)
+{
+	// makes the current population the one answering xcs_serve_action
+	(void)x;
+	snap_publish(&pset);
+}
+
+int xcs_serve_action(int reader, const char *state, const double *dstate, 
+		double *payoff, long *epoch)
+{
+	// may be called from any thread, each using its own reader number, while
+	// the learner trains; returns -1 if no published classifier matches
+	double conv[dstate_length];
+	if(dstate == NULL) {
+		for(int i = 0; i < dstate_length; i++)
+			conv[i] = (i < state_length && state[i] == '1') ? 1.0 : -1.0;
+		dstate = conv;
+	}
+	SNAP *s = snap_enter(reader);
+	int action = snap_action(s, (char *)state, (double *)dstate, payoff);
+	if(epoch != NULL)
+		*epoch = (s != NULL) ? s->epoch : 0;
+	snap_exit(reader);
+	return action;
+}
+
+int xcs_predict_batch(XCS *x, const char *states, const double *dstates, 
+		int n, int *actions, double *payoffs)
+{
+	// best action and its payoff per instance; the population is not changed
+	for(int i = 0; i < n; i++) {
+		char *state = (char *)&states[i*state_length];
+		double *dstate = xcs_dstate(x, state, 
+				dstates ? &dstates[i*dstate_length] : NULL);
+		NODE *mset = NULL;
+		pop_match(&mset, state, dstate);
+		pa_build(&mset, dstate);
+		actions[i] = pa_best_action();
+		if(payoffs != NULL)
+			payoffs[i] = pa_best_val();
+		set_free(&mset);
+	}
+	return 0;
+}
+
+size_t xcs_cl_size()
+{
+	// bytes used by one saved classifier with the current parameters
+	CL *c = malloc(sizeof(CL));
+	cl_init(c, 0, 0);
+	size_t size = cl_save(c, NULL);
+	cl_free(c);
+	return size;
+}
+
+size_t xcs_save(XCS *x, void *buf, size_t size)
+{
+	// writes the population to buf if it is large enough and returns the
+	// number of bytes needed
+	size_t need = sizeof(int)*XCS_HEADER;
+	size_t cl_size = (pset != NULL) ? cl_save(pset->cl, NULL) : 0;
+	need += pop_num*cl_size;
+	if(buf == NULL || size < need)
+		return need;
+	int head[XCS_HEADER] = {0x31534358, state_length, dstate_length, 
+		num_actions, XCS_PRED*2+XCS_QUAD+COND_TYPE*8+XCS_REAL*32, XCS_MU, 
+		pop_num, x->time};
+	char *b = buf;
+	memcpy(b, head, sizeof(head));
+	b += sizeof(head);
+	// oldest first so that reloading rebuilds the same list; the list holds
+	// the newest first and every classifier takes cl_size bytes, so they
+	// are written from the end
+	b += pop_num*cl_size;
+	for(NODE *iter = pset; iter != NULL; iter = iter->next) {
+		b -= cl_size;
+		cl_save(iter->cl, b);
+	}
+	return need;
+}
+
+int xcs_load(XCS *x, const void *buf, size_t size)
+{
+	// replaces the population with one written by xcs_save
+	int num = xcs_check(buf, size);
+	if(num < 0)
+		return -1;
+	pop_free();
+	_Bool init = POP_INIT;
+	POP_INIT = false;
+	pop_init();
+	POP_INIT = init;
+	char *b = (char *)buf + sizeof(int)*XCS_HEADER;
+	for(int i = 0; i < num; i++) {
+		CL *c = malloc(sizeof(CL));
+		cl_init(c, 0, 0);
+		b += cl_load(c, b);
+		pop_insert(c);
+	}
+	memcpy(&x->time, (char *)buf + sizeof(int)*(XCS_HEADER-1), sizeof(int));
+	return 0;
+}
+
+int xcs_merge(XCS *x, const void *buf, size_t size)
+{
+	// adds the classifiers written by xcs_save to the population, combining
+	// duplicates; the population size limit is not enforced
+	(void)x;
+	int num = xcs_check(buf, size);
+	if(num < 0)
+		return -1;
+	char *b = (char *)buf + sizeof(int)*XCS_HEADER;
+	for(int i = 0; i < num; i++) {
+		CL *c = malloc(sizeof(CL));
+		cl_init(c, 0, 0);
+		b += cl_load(c, b);
+		pop_add(c);
+	}
+	return 0;
+}
+
+int xcs_check(const void *buf, size_t size)
+{
+	// the number of classifiers in a saved population, or -1 if it was not
+	// saved with the current problem, condition and prediction settings
+	int head[XCS_HEADER];
+	if(size < sizeof(head))
+		return -1;
+	memcpy(head, buf, sizeof(head));
+	if(head[0] != 0x31534358 || head[1] != state_length 
+			|| head[2] != dstate_length || head[3] != num_actions
+			|| head[4] != XCS_PRED*2+XCS_QUAD+COND_TYPE*8+XCS_REAL*32 
+			|| head[5] != XCS_MU
+			|| head[6] < 0
+			|| size != sizeof(head) + head[6]*xcs_cl_size())
+		return -1;
+	return head[6];
+}
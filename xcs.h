@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2015 Richard Preen <rpreen@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ************
+ * Description:
+ * ************
+ *
+ * The libxcs C interface. See xcs.c.
+ */
+
+#include <stddef.h>
+
+typedef struct XCS XCS;
+
+typedef struct XCS_PARAMS {
+	// problem
+	int state_length; // number of binary inputs
+	int dstate_length; // number of real inputs (0 = state_length, from the bits)
+	int num_actions; // number of actions
+	unsigned long seed; // random seed (0 = leave the generator as it is)
+	// population
+	_Bool pop_init; // whether to start with a random population
+	int pop_size; // maximum number of micro-classifiers
+	// classifier
+	double alpha;
+	double beta;
+	double delta;
+	double eps_0;
+	double err_reduc;
+	double fit_reduc;
+	double gamma;
+	double init_error;
+	double init_fitness;
+	double nu;
+	double theta_del;
+	// genetic algorithm
+	double p_crossover;
+	double p_mutation;
+	double theta_ga;
+	int theta_mna; // actions covered in a match set (0 = all)
+	int ga_queue; // GA runs handed to a separate thread (0 = synchronous)
+	int ga_stale; // time steps before a queued GA run must be applied
+	double mu_eps_0;
+	int num_mu;
+	// condition and prediction
+	double p_dontcare;
+	int cond_type; // 0 = ternary over state, 1 = intervals over dstate, 2 = sparse ternary
+	double cond_s0; // interval covering spread
+	double cond_m0; // interval mutation step
+	double init_prediction;
+	double xcsf_eta;
+	double xcsf_x0;
+	// subsumption
+	_Bool action_subsumption;
+	_Bool ga_subsumption;
+	double theta_sub;
+	// matching and threads
+	int match_cache_size;
+	_Bool match_delta;
+	int match_index;
+	int num_threads;
+	int par_match_min;
+	int par_pa_min;
+	int infer_table_bits;
+	int batch_size; // inputs explored together by xcs_train_batch
+	// serving
+	int serve_readers; // threads that may query published snapshots
+} XCS_PARAMS;
+
+XCS *xcs_create(const XCS_PARAMS *p);
+int xcs_load(XCS *x, const void *buf, size_t size);
+int xcs_merge(XCS *x, const void *buf, size_t size);
+int xcs_predict_batch(XCS *x, const char *states, const double *dstates, 
+		int n, int *actions, double *payoffs);
+int xcs_train_batch(XCS *x, const char *states, const double *dstates, 
+		const double *rewards, int n);
+int xcs_serve_action(int reader, const char *state, const double *dstate, 
+		double *payoff, long *epoch);
+int xcs_update(XCS *x, const char *state, const double *dstate, int action, 
+		double reward);
+size_t xcs_save(XCS *x, void *buf, size_t size);
+void xcs_default_params(XCS_PARAMS *p);
+void xcs_destroy(XCS *x);
+void xcs_publish(XCS *x);